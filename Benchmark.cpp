@@ -0,0 +1,877 @@
+//
+//  Benchmark.cpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+//  Benchmarks are ordinary tests which print their timings. By default they run on small data sets
+//  to keep the test run short, set JET_CONFIG_BENCHMARK_SCALE environment variable to make data bigger.
+//
+#include "gtest.hpp"
+#include "Config.hpp"
+#include "ConfigBinding.hpp"
+#include "ConfigError.hpp"
+#include "ConfigPathIndex.hpp"
+#include "ConfigReloader.hpp"
+#include "ConfigSnapshots.hpp"
+#include "ConfigSourceCache.hpp"
+#include "ConfigSubscriptions.hpp"
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/move/utility_core.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace boost::placeholders;
+
+namespace
+{
+
+unsigned benchmarkScale()
+{
+    const char* scale = std::getenv("JET_CONFIG_BENCHMARK_SCALE");
+    if(!scale)
+        return 1;
+    try
+    {
+        return std::max(1u, boost::lexical_cast<unsigned>(scale));
+    }
+    catch(const boost::bad_lexical_cast&)
+    {
+        return 1;
+    }
+}
+
+class Stopwatch
+{
+public:
+    Stopwatch(): start_(now()) {}
+    double seconds() const { return (now() - start_).total_microseconds() / 1e6; }
+private:
+    static boost::posix_time::ptime now() { return boost::posix_time::microsec_clock::universal_time(); }
+    const boost::posix_time::ptime start_;
+};
+
+//...files of benchmarks are in the temporary directory, with unique names, so they can run at the same time
+boost::filesystem::path temporaryPath(const std::string& model)
+{
+    return boost::filesystem::temp_directory_path() / boost::filesystem::unique_path(model);
+}
+
+void report(const std::string& benchmark, double seconds, size_t bytes)
+{
+    std::cout << "[ BENCH    ] " << benchmark << ": " << seconds * 1e3 << " ms";
+    if(bytes && seconds > 0)
+        std::cout << ", " << bytes / seconds / (1 << 20) << " MB/s";
+    std::cout << std::endl;
+}
+
+//...fleet config with 'apps' applications, each of them has 'instances' instances and 'properties' properties
+std::string makeXmlSource(unsigned apps, unsigned instances, unsigned properties)
+{
+    std::ostringstream strm;
+    strm << "<config>\n  <shared>\n    <lib timeout='10' host='localhost'/>\n  </shared>\n";
+    for(unsigned app = 0; app != apps; ++app)
+    {
+        strm << "  <app" << app << ">\n";
+        for(unsigned property = 0; property != properties; ++property)
+            strm << "    <property" << property << ">value" << property << "</property" << property << ">\n";
+        strm << "  </app" << app << ">\n";
+        for(unsigned instance = 0; instance != instances; ++instance)
+            strm << "  <app" << app << ":i" << instance << " port='" << 1000 + instance << "' host='host" << instance << "'/>\n";
+    }
+    strm << "</config>\n";
+    return strm.str();
+}
+
+std::string makeJsonSource(unsigned apps, unsigned instances, unsigned properties)
+{
+    std::ostringstream strm;
+    strm << "{\n  \"config\": {\n    \"shared\": { \"lib\": { \"timeout\": 10, \"host\": \"localhost\" } }";
+    for(unsigned app = 0; app != apps; ++app)
+    {
+        strm << ",\n    \"app" << app << "\": {";
+        for(unsigned property = 0; property != properties; ++property)
+            strm << (property ? ", " : " ") << "\"property" << property << "\": \"value" << property << '"';
+        strm << " }";
+        for(unsigned instance = 0; instance != instances; ++instance)
+            strm << ",\n    \"app" << app << ":i" << instance << "\": { \"port\": " << 1000 + instance << ", \"host\": \"host" << instance << "\" }";
+    }
+    strm << "\n  }\n}\n";
+    return strm.str();
+}
+
+struct FleetSettings
+{
+    std::string property0, property3, property7, property11, property17, host, timeout;
+    int port;
+};
+
+}//anonymous namespace
+
+TEST(Benchmark, JsonSourceVsXmlSource)
+{
+    const unsigned scale = benchmarkScale();
+    const std::string xml(makeXmlSource(100 * scale, 4, 20));
+    const std::string json(makeJsonSource(100 * scale, 4, 20));
+    {
+        Stopwatch stopwatch;
+        std::istringstream strm(xml);
+        boost::property_tree::ptree tree;
+        boost::property_tree::read_xml(strm, tree, boost::property_tree::xml_parser::trim_whitespace);
+        report("PT::read_xml", stopwatch.seconds(), xml.size());
+    }
+    Stopwatch xmlStopwatch;
+    const jet::ConfigSource xmlSource(xml, "fleet.xml");
+    report("ConfigSource(xml)", xmlStopwatch.seconds(), xml.size());
+    Stopwatch jsonStopwatch;
+    const jet::ConfigSource jsonSource(json, "fleet.json", jet::ConfigSource::json);
+    report("ConfigSource(json)", jsonStopwatch.seconds(), json.size());
+    EXPECT_EQ(xmlSource.toString(), jsonSource.toString());
+}
+
+TEST(Benchmark, SinglePassXmlParser)
+{
+    const unsigned scale = benchmarkScale();
+    const std::string xml(makeXmlSource(100 * scale, 4, 20));
+    Stopwatch defaultStopwatch;
+    const jet::ConfigSource defaultSource(xml, "fleet.xml");
+    report("ConfigSource(xml, DefaultParser)", defaultStopwatch.seconds(), xml.size());
+    Stopwatch singlePassStopwatch;
+    const jet::ConfigSource singlePassSource(
+        xml,
+        "fleet.xml",
+        jet::ConfigSource::xml,
+        jet::ConfigSource::CaseSensitive,
+        jet::ConfigSource::SinglePassParser);
+    report("ConfigSource(xml, SinglePassParser)", singlePassStopwatch.seconds(), xml.size());
+    EXPECT_EQ(defaultSource.toString(), singlePassSource.toString());
+}
+
+TEST(Benchmark, BufferSource)
+{
+    const unsigned scale = benchmarkScale();
+    const std::string xml(makeXmlSource(100 * scale, 4, 20));
+    Stopwatch streamStopwatch;
+    std::stringstream strm;
+    strm << xml;
+    const jet::ConfigSource streamSource(strm, "fleet.xml");
+    report("ConfigSource(stringstream)", streamStopwatch.seconds(), xml.size());
+    Stopwatch bufferStopwatch;
+    const jet::ConfigSource bufferSource(xml.data(), xml.size(), "fleet.xml");
+    report("ConfigSource(buffer)", bufferStopwatch.seconds(), xml.size());
+    EXPECT_EQ(streamSource.toString(), bufferSource.toString());
+}
+
+TEST(Benchmark, MappedFileParser)
+{
+    const unsigned scale = benchmarkScale();
+    const std::string filename(temporaryPath("JetConfigMappedFileParserBenchmark-%%%%-%%%%-%%%%.xml").string());
+    const std::string xml(makeXmlSource(100 * scale, 4, 20));
+    std::ofstream(filename.c_str()) << xml;
+    Stopwatch defaultStopwatch;
+    const jet::ConfigSource defaultSource(jet::ConfigSource::createFromFile(filename));
+    report("createFromFile(DefaultParser)", defaultStopwatch.seconds(), xml.size());
+    Stopwatch mappedStopwatch;
+    const jet::ConfigSource mappedSource(
+        jet::ConfigSource::createFromFile(
+            filename,
+            jet::ConfigSource::xml,
+            jet::ConfigSource::CaseSensitive,
+            jet::ConfigSource::MappedFileParser));
+    report("createFromFile(MappedFileParser)", mappedStopwatch.seconds(), xml.size());
+    std::remove(filename.c_str());
+    EXPECT_EQ(defaultSource.toString(), mappedSource.toString());
+}
+
+TEST(Benchmark, DirectoryLoading)
+{
+    namespace FS = boost::filesystem;
+    const unsigned scale = benchmarkScale();
+    const FS::path directory(temporaryPath("JetConfigDirectoryBenchmark-%%%%-%%%%-%%%%.d"));
+    FS::create_directory(directory);
+    size_t bytes = 0;
+    std::vector<std::string> filenames;
+    for(unsigned file = 0; file != 32; ++file)
+    {
+        const std::string xml(makeXmlSource(10 * scale, 4, 20));
+        filenames.push_back((directory / ("fragment" + boost::lexical_cast<std::string>(file) + ".xml")).string());
+        std::ofstream(filenames.back().c_str()) << xml;
+        bytes += xml.size();
+    }
+    Stopwatch serialStopwatch;
+    jet::Config serialConfig("app0");
+    BOOST_FOREACH(const std::string& filename, filenames)
+        serialConfig << jet::ConfigSource::createFromFile(filename);
+    serialConfig << jet::lock;
+    report("createFromFile x 32", serialStopwatch.seconds(), bytes);
+    Stopwatch parallelStopwatch;
+    jet::Config parallelConfig("app0");
+    parallelConfig << jet::ConfigSource::createFromDirectory(directory.string()) << jet::lock;
+    report("createFromDirectory(32 files)", parallelStopwatch.seconds(), bytes);
+    FS::remove_all(directory);
+    std::ostringstream serial, parallel;
+    serial << serialConfig;
+    parallel << parallelConfig;
+    EXPECT_EQ(serial.str(), parallel.str());
+}
+
+TEST(Benchmark, WideSourceScaling)
+{//...time per application must stay flat while the source grows, that is loading must be linear
+    const unsigned scale = benchmarkScale();
+    for(unsigned apps = 100 * scale; apps <= 10000 * scale; apps *= 10)
+    {
+        const std::string xml(makeXmlSource(apps, 4, 2));
+        Stopwatch stopwatch;
+        const jet::ConfigSource source(
+            xml,
+            "wide.xml",
+            jet::ConfigSource::xml,
+            jet::ConfigSource::CaseSensitive,
+            jet::ConfigSource::SinglePassParser);
+        const double seconds = stopwatch.seconds();
+        report("ConfigSource(" + boost::lexical_cast<std::string>(apps) + " apps)", seconds, xml.size());
+        std::cout << "[ BENCH    ]     " << seconds * 1e6 / apps << " us per app" << std::endl;
+    }
+}
+
+TEST(Benchmark, WideAttributeTable)
+{//...flat key table encoded as attributes of one element
+    const unsigned scale = benchmarkScale();
+    std::ostringstream strm;
+    strm << "<config><app><table";
+    for(unsigned key = 0; key != 10000 * scale; ++key)
+        strm << " key" << key << "='" << key << "'";
+    strm << "/></app></config>";
+    const std::string xml(strm.str());
+    Stopwatch stopwatch;
+    const jet::ConfigSource source(xml, "table.xml");
+    report("ConfigSource(" + boost::lexical_cast<std::string>(10000 * scale) + " attributes)", stopwatch.seconds(), xml.size());
+}
+
+TEST(Benchmark, SnapshotWarmStart)
+{
+    const unsigned scale = benchmarkScale();
+    const std::string filename(temporaryPath("JetConfigSnapshotBenchmark-%%%%-%%%%-%%%%.bin").string());
+    const std::string xml(makeXmlSource(100 * scale, 4, 20));
+    std::ostringstream app;
+    app << "<config><app0>";
+    for(unsigned property = 0; property != 10000 * scale; ++property)
+        app << "<key" << property << " value='" << property << "'/>";
+    app << "</app0></config>";
+    Stopwatch coldStopwatch;
+    jet::Config cold("app0", "i1");
+    cold << jet::ConfigSource(xml, "fleet.xml") << jet::ConfigSource(app.str(), "app0.xml") << jet::lock;
+    report("Config from sources", coldStopwatch.seconds(), xml.size() + app.str().size());
+    cold.saveSnapshot(filename);
+    Stopwatch warmStopwatch;
+    jet::Config warm("app0", "i1");
+    warm.loadSnapshot(filename);
+    report("Config from snapshot", warmStopwatch.seconds(), 0);
+    std::remove(filename.c_str());
+    EXPECT_EQ(cold.get("key999.value"), warm.get("key999.value"));
+}
+
+TEST(Benchmark, ParseCache)
+{
+    namespace FS = boost::filesystem;
+    const unsigned scale = benchmarkScale();
+    const FS::path directory(temporaryPath("JetConfigParseCacheBenchmark-%%%%-%%%%-%%%%.d"));
+    FS::create_directory(directory);
+    const std::string filename((directory / "fleet.xml").string());
+    const std::string xml(makeXmlSource(100 * scale, 4, 20));
+    std::ofstream(filename.c_str()) << xml;
+    jet::ConfigSourceCache cache(directory.string());
+    Stopwatch missStopwatch;
+    const jet::ConfigSource parsed(cache.createFromFile(filename));
+    report("ConfigSourceCache miss", missStopwatch.seconds(), xml.size());
+    Stopwatch hitStopwatch;
+    const jet::ConfigSource cached(cache.createFromFile(filename));
+    report("ConfigSourceCache hit", hitStopwatch.seconds(), xml.size());
+    FS::remove_all(directory);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(parsed.toString(), cached.toString());
+}
+
+TEST(Benchmark, FilteredSource)
+{
+    const unsigned scale = benchmarkScale();
+    const std::string xml(makeXmlSource(800 * scale, 4, 20));
+    Stopwatch fullStopwatch;
+    jet::Config full("app42", "i1");
+    full << jet::ConfigSource(xml, "fleet.xml", jet::ConfigSource::xml, jet::ConfigSource::CaseSensitive,
+        jet::ConfigSource::SinglePassParser) << jet::lock;
+    report("Config(app42:i1) from the whole source", fullStopwatch.seconds(), xml.size());
+    Stopwatch filteredStopwatch;
+    jet::Config filtered("app42", "i1");
+    filtered << jet::ConfigSource(xml, jet::ConfigSource::Filter("app42", "i1"), "fleet.xml") << jet::lock;
+    report("Config(app42:i1) from filtered source", filteredStopwatch.seconds(), xml.size());
+    std::ostringstream fullOutput;
+    fullOutput << full;
+    std::ostringstream filteredOutput;
+    filteredOutput << filtered;
+    EXPECT_EQ(fullOutput.str(), filteredOutput.str());
+}
+
+TEST(Benchmark, StreamingSerialization)
+{
+    const unsigned scale = benchmarkScale();
+    const std::string xml(makeXmlSource(100 * scale, 4, 20));
+    const jet::ConfigSource source(xml, "fleet.xml");
+    boost::property_tree::ptree tree;
+    {
+        std::istringstream strm(source.toString());
+        boost::property_tree::read_xml(strm, tree, boost::property_tree::xml_parser::trim_whitespace);
+    }
+    Stopwatch ptreeStopwatch;
+    std::string ptreeOutput;
+    {//...the way toString worked before: write_xml into a buffer and cut '<?xml ...?>' line off
+        std::stringstream strm;
+        boost::property_tree::write_xml(strm, tree, boost::property_tree::xml_writer_make_settings<std::string>(' ', 2));
+        std::string firstString;
+        std::getline(strm, firstString);
+        ptreeOutput = strm.str().substr(firstString.size() + 1);
+    }
+    report("PT::write_xml", ptreeStopwatch.seconds(), ptreeOutput.size());
+    Stopwatch xmlStopwatch;
+    std::ostringstream xmlOutput;
+    source.write(xmlOutput);
+    report("ConfigSource::write(xml)", xmlStopwatch.seconds(), xmlOutput.str().size());
+    Stopwatch jsonStopwatch;
+    std::ostringstream jsonOutput;
+    source.write(jsonOutput, jet::ConfigSource::Pretty, jet::ConfigSource::json);
+    report("ConfigSource::write(json)", jsonStopwatch.seconds(), jsonOutput.str().size());
+    EXPECT_EQ(ptreeOutput, xmlOutput.str());
+}
+
+TEST(Benchmark, MovedSourceMerge)
+{
+    const unsigned scale = benchmarkScale();
+    std::ostringstream strm;
+    strm << "<app>";
+    for(unsigned section = 0; section != 1000 * scale; ++section)
+        strm << "<section" << section << " timeout='10' host='localhost'><pool size='4' limit='16'/></section" << section << ">";
+    strm << "</app>";
+    const std::string xml(strm.str());
+    const jet::ConfigSource copiedSource(xml, "app.xml");
+    jet::ConfigSource movedSource(xml, "app.xml");
+    Stopwatch copyStopwatch;
+    jet::Config copied("app");
+    copied << copiedSource;
+    report("Config << source", copyStopwatch.seconds(), xml.size());
+    Stopwatch moveStopwatch;
+    jet::Config moved("app");
+    moved << boost::move(movedSource);
+    report("Config << boost::move(source)", moveStopwatch.seconds(), xml.size());
+    copied << jet::lock;
+    moved << jet::lock;
+    std::ostringstream copiedOutput;
+    copiedOutput << copied;
+    std::ostringstream movedOutput;
+    movedOutput << moved;
+    EXPECT_EQ(copiedOutput.str(), movedOutput.str());
+}
+
+TEST(Benchmark, LayeredSourcesMerge)
+{
+    const unsigned scale = benchmarkScale();
+    const unsigned layerCounts[] = { 10, 100, 1000 };
+    BOOST_FOREACH(const unsigned layerCount, layerCounts)
+    {
+        jet::ConfigSources sources;
+        size_t bytes = 0;
+        for(unsigned layer = 0; layer != layerCount * scale; ++layer)
+        {//...every layer overrides some keys of the same sections and adds its own ones
+            std::ostringstream strm;
+            strm << "<config><shared><lib timeout='" << layer << "'/></shared><app>";
+            for(unsigned section = 0; section != 50; ++section)
+                strm << "<section" << section << " key" << layer % 10 << "='" << layer << "'><pool size='" << layer << "'/></section" << section << ">";
+            strm << "<layer" << layer << " value='" << layer << "'/></app>";
+            strm << "<app:i1 port='" << 1000 + layer << "'/></config>";
+            const std::string xml(strm.str());
+            bytes += xml.size();
+            sources.push_back(jet::ConfigSource(xml, "layer" + boost::lexical_cast<std::string>(layer) + ".xml"));
+        }
+        const std::string suffix(" (" + boost::lexical_cast<std::string>(sources.size()) + " sources)");
+        Stopwatch sequentialStopwatch;
+        jet::Config sequential("app", "i1");
+        BOOST_FOREACH(const jet::ConfigSource& source, sources)
+            sequential << source;
+        report("Config << source" + suffix, sequentialStopwatch.seconds(), bytes);
+        Stopwatch bulkStopwatch;
+        jet::Config bulk("app", "i1");
+        bulk << sources;
+        report("Config << sources" + suffix, bulkStopwatch.seconds(), bytes);
+        sequential << jet::lock;
+        bulk << jet::lock;
+        std::ostringstream sequentialOutput;
+        sequentialOutput << sequential;
+        std::ostringstream bulkOutput;
+        bulkOutput << bulk;
+        EXPECT_EQ(sequentialOutput.str(), bulkOutput.str());
+    }
+}
+
+TEST(Benchmark, FrozenTreeLookup)
+{
+    const unsigned scale = benchmarkScale();
+    const unsigned sections = 1000 * scale;
+    std::ostringstream strm;
+    strm << "<config><app>";
+    for(unsigned section = 0; section != sections; ++section)
+        strm << "<section" << section << " timeout='10' host='localhost' port='" << 1000 + section % 10 << "'><pool size='4' limit='16'/></section" << section << ">";
+    strm << "</app></config>";
+    const std::string xml(strm.str());
+    boost::property_tree::ptree tree;//...the same tree as the config had before it was frozen
+    std::vector<std::string> keys;
+    for(unsigned section = 0; section != sections; ++section)
+    {
+        const std::string name("section" + boost::lexical_cast<std::string>(section));
+        tree.put(name + ".timeout", "10");
+        tree.put(name + ".host", "localhost");
+        tree.put(name + ".port", 1000 + section % 10);
+        tree.put(name + ".pool.size", "4");
+        tree.put(name + ".pool.limit", "16");
+        keys.push_back(name + ".port");
+        keys.push_back(name + ".pool.limit");
+    }
+    jet::Config config("app");
+    config << jet::ConfigSource(xml, "app.xml") << jet::lock;
+    const std::string filename(temporaryPath("JetConfigFrozenTreeBenchmark-%%%%-%%%%-%%%%.bin").string());
+    config.saveSnapshot(filename);
+    const size_t nodes = sections * 7 + 1;
+    std::cout << "[ BENCH    ] " << nodes << " nodes, ptree: more than " <<
+        nodes * sizeof(boost::property_tree::ptree::value_type) << " bytes, frozen tree: " <<
+        boost::filesystem::file_size(filename) << " bytes" << std::endl;
+    std::remove(filename.c_str());
+    const unsigned rounds = 100;
+    size_t ptreeSize = 0;
+    Stopwatch ptreeStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        BOOST_FOREACH(const std::string& key, keys)
+            ptreeSize += tree.get_child(key).data().size();
+    }
+    report("ptree::get_child", ptreeStopwatch.seconds(), 0);
+    size_t configSize = 0;
+    Stopwatch configStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        BOOST_FOREACH(const std::string& key, keys)
+            configSize += config.get(key).size();
+    }
+    report("Config::get", configStopwatch.seconds(), 0);
+    EXPECT_EQ(ptreeSize, configSize);
+}
+
+TEST(Benchmark, PrecompiledPathLookup)
+{//...request handler reads the same few keys over and over
+    const unsigned scale = benchmarkScale();
+    jet::Config config("app0", "i1");
+    config << jet::ConfigSource(makeXmlSource(100, 4, 20), "fleet.xml") << jet::lock;
+    const char* const names[] = { "property3", "property17", "port", "lib.timeout" };
+    std::vector<std::string> keys(names, names + 4);
+    std::vector<jet::ConfigPath> paths(names, names + 4);
+    const unsigned rounds = 100000 * scale;
+    size_t stringSum = 0;
+    Stopwatch stringStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        BOOST_FOREACH(const std::string& key, keys)
+            stringSum += config.get<std::string>(key).size();
+    }
+    report("Config::get<std::string>(std::string)", stringStopwatch.seconds(), 0);
+    size_t pathSum = 0;
+    Stopwatch pathStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        BOOST_FOREACH(const jet::ConfigPath& path, paths)
+            pathSum += config.get<std::string>(path).size();
+    }
+    report("Config::get<std::string>(ConfigPath)", pathStopwatch.seconds(), 0);
+    EXPECT_EQ(stringSum, pathSum);
+    Stopwatch intStopwatch;
+    size_t intSum = 0;
+    for(unsigned round = 0; round != rounds; ++round)
+        intSum += config.get<int>(keys[2]);
+    report("Config::get<int>(std::string)", intStopwatch.seconds(), 0);
+    Stopwatch intPathStopwatch;
+    size_t intPathSum = 0;
+    for(unsigned round = 0; round != rounds; ++round)
+        intPathSum += config.get<int>(paths[2]);
+    report("Config::get<int>(ConfigPath)", intPathStopwatch.seconds(), 0);
+    EXPECT_EQ(intSum, intPathSum);
+}
+
+TEST(Benchmark, PathIndexLookup)
+{//...deep paths in a wide tree, every key of a path is a lookup among many siblings without the index
+    const unsigned scale = benchmarkScale();
+    const unsigned sections = 1000 * scale;
+    boost::property_tree::ptree tree;
+    std::vector<std::string> keys;
+    for(unsigned section = 0; section != sections; ++section)
+    {
+        const std::string name("section" + boost::lexical_cast<std::string>(section));
+        for(unsigned pool = 0; pool != 4; ++pool)
+        {
+            const std::string poolName(name + ".pool" + boost::lexical_cast<std::string>(pool));
+            tree.put(poolName + ".size", "4");
+            tree.put(poolName + ".limits.connections", 16 + pool);
+            keys.push_back(poolName + ".limits.connections");
+        }
+    }
+    const jet::ConfigImage image(tree, "app", std::string());
+    Stopwatch buildStopwatch;
+    const jet::ConfigPathIndex index(image);
+    report("ConfigPathIndex::ConfigPathIndex", buildStopwatch.seconds(), 0);
+    std::cout << "[ BENCH    ] " << image.nodeCount() << " nodes, image: " << image.size() <<
+        " bytes, path index: " << index.size() << " bytes" << std::endl;
+    const unsigned rounds = 20;
+    size_t walkSize = 0;
+    Stopwatch walkStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        BOOST_FOREACH(const std::string& key, keys)
+            walkSize += image.findPath(image.root(), key)->dataSize;
+    }
+    report("ConfigImage::findPath", walkStopwatch.seconds(), 0);
+    size_t indexSize = 0;
+    Stopwatch indexStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        BOOST_FOREACH(const std::string& key, keys)
+        {
+            const jet::ConfigImage::Node* node = index.find(
+                jet::ConfigPathIndex::hash(jet::ConfigPathIndex::emptyPathHash(), key.data(), key.size()));
+            if(node && index.isPath(image.root(), *node, key.data(), key.size()))
+                indexSize += node->dataSize;
+        }
+    }
+    report("ConfigPathIndex::find", indexStopwatch.seconds(), 0);
+    EXPECT_EQ(walkSize, indexSize);
+}
+
+TEST(Benchmark, TypedValueCache)
+{//...the same properties are converted over and over, the conversion is done once with the cache
+    const unsigned scale = benchmarkScale();
+    jet::Config config("app0", "i1");
+    config << jet::ConfigSource(makeXmlSource(100, 4, 20), "fleet.xml") << jet::lock;
+    const std::string port("port");
+    const jet::ConfigPath portPath("port");
+    const unsigned rounds = 100000 * scale;
+    size_t castSum = 0;
+    Stopwatch castStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+        castSum += boost::lexical_cast<int>(config.get(port)) + static_cast<size_t>(boost::lexical_cast<double>(config.get(port)));
+    report("lexical_cast<int, double>(Config::get)", castStopwatch.seconds(), 0);
+    size_t cachedSum = 0;
+    Stopwatch cachedStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+        cachedSum += config.get<int>(port) + static_cast<size_t>(config.get<double>(port));
+    report("Config::get<int, double>(std::string)", cachedStopwatch.seconds(), 0);
+    EXPECT_EQ(castSum, cachedSum);
+    size_t pathSum = 0;
+    Stopwatch pathStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+        pathSum += config.get<int>(portPath) + static_cast<size_t>(config.get<double>(portPath));
+    report("Config::get<int, double>(ConfigPath)", pathStopwatch.seconds(), 0);
+    EXPECT_EQ(castSum, pathSum);
+}
+
+TEST(Benchmark, ValueConverters)
+{//...conversion alone, without config lookup and cache
+    const unsigned scale = benchmarkScale();
+    std::vector<std::string> integers, reals;
+    for(unsigned i = 0; i != 1000; ++i)
+    {
+        integers.push_back(boost::lexical_cast<std::string>(i * 7919));
+        reals.push_back(boost::lexical_cast<std::string>(i * 0.125 + 1e-3));
+    }
+    const unsigned rounds = 200 * scale;
+    long long castSum = 0;
+    double castRealSum = 0;
+    Stopwatch castStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        for(size_t i = 0; i != integers.size(); ++i)
+        {
+            castSum += boost::lexical_cast<int>(integers[i].data(), integers[i].size());
+            castRealSum += boost::lexical_cast<double>(reals[i].data(), reals[i].size());
+        }
+    }
+    report("lexical_cast<int, double>", castStopwatch.seconds(), 0);
+    long long converterSum = 0;
+    double converterRealSum = 0;
+    Stopwatch converterStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        for(size_t i = 0; i != integers.size(); ++i)
+        {
+            int integer = 0;
+            double real = 0;
+            jet::ConfigConverter<int>::convert(integers[i].data(), integers[i].size(), integer);
+            jet::ConfigConverter<double>::convert(reals[i].data(), reals[i].size(), real);
+            converterSum += integer;
+            converterRealSum += real;
+        }
+    }
+    report("ConfigConverter<int, double>", converterStopwatch.seconds(), 0);
+    EXPECT_EQ(castSum, converterSum);
+    EXPECT_DOUBLE_EQ(castRealSum, converterRealSum);
+}
+
+TEST(Benchmark, StructBinding)
+{//...service reads its settings struct at startup
+    const unsigned scale = benchmarkScale();
+    jet::Config config("app0", "i1");
+    config << jet::ConfigSource(makeXmlSource(100, 4, 20), "fleet.xml") << jet::lock;
+    const unsigned rounds = 20000 * scale;
+    size_t getSum = 0;
+    Stopwatch getStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        FleetSettings settings;
+        settings.property0 = config.get("property0");
+        settings.property3 = config.get("property3");
+        settings.property7 = config.get("property7");
+        settings.property11 = config.get("property11");
+        settings.property17 = config.get("property17");
+        settings.host = config.get("host");
+        settings.timeout = config.get("lib.timeout");
+        settings.port = config.get<int>("port");
+        getSum += settings.property17.size() + settings.port;
+    }
+    report("Config::get for every field", getStopwatch.seconds(), 0);
+    const jet::ConfigBinding<FleetSettings> binding = jet::ConfigBinding<FleetSettings>()
+        .field(&FleetSettings::property0, "property0")
+        .field(&FleetSettings::property3, "property3")
+        .field(&FleetSettings::property7, "property7")
+        .field(&FleetSettings::property11, "property11")
+        .field(&FleetSettings::property17, "property17")
+        .field(&FleetSettings::host, "host")
+        .field(&FleetSettings::timeout, "lib.timeout")
+        .field(&FleetSettings::port, "port");
+    size_t bindSum = 0;
+    Stopwatch bindStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        const FleetSettings settings(binding.bind(config));
+        bindSum += settings.property17.size() + settings.port;
+    }
+    report("ConfigBinding::bind", bindStopwatch.seconds(), 0);
+    EXPECT_EQ(getSum, bindSum);
+}
+
+TEST(Benchmark, NodeViewWalk)
+{//...request handler walks sections of config and reads a property of every one
+    const unsigned scale = benchmarkScale();
+    std::ostringstream strm;
+    strm << "<config><app>";
+    for(unsigned section = 0; section != 100; ++section)
+        strm << "<route" << section << " port='" << 1000 + section << "'><backend host='host" << section << "'/></route" << section << ">";
+    strm << "</app></config>";
+    jet::Config config("app");
+    config << jet::ConfigSource(strm.str(), "app.xml") << jet::lock;
+    const unsigned rounds = 2000 * scale;
+    size_t nodeSum = 0;
+    Stopwatch nodeStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        BOOST_FOREACH(const jet::ConfigNode& route, config.getChildrenOf())
+            nodeSum += route.get<int>("port") + route.getNode("backend").get("host").size();
+    }
+    report("ConfigNode", nodeStopwatch.seconds(), 0);
+    size_t viewSum = 0;
+    Stopwatch viewStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        BOOST_FOREACH(const jet::ConfigNodeView& route, config.view().getChildrenOf())
+            viewSum += route.get<int>("port") + route.getNode("backend").get("host").size();
+    }
+    report("ConfigNodeView", viewStopwatch.seconds(), 0);
+    EXPECT_EQ(nodeSum, viewSum);
+}
+
+TEST(Benchmark, ChildrenRange)
+{//...routing table with many entries is scanned for one of them
+    const unsigned scale = benchmarkScale();
+    const unsigned routes = 10000;
+    std::ostringstream strm;
+    strm << "<config><app><routes>";
+    for(unsigned route = 0; route != routes; ++route)
+        strm << "<route" << route << " port='" << 1000 + route % 1000 << "'/>";
+    strm << "</routes></app></config>";
+    jet::Config config("app");
+    config << jet::ConfigSource(strm.str(), "app.xml") << jet::lock;
+    const std::string wanted("route" + boost::lexical_cast<std::string>(routes - 1));
+    const jet::ConfigPath routesPath("routes");
+    const unsigned rounds = 20 * scale;
+    size_t vectorFound = 0;
+    Stopwatch vectorStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        BOOST_FOREACH(const jet::ConfigNode& route, config.getChildrenOf("routes"))
+        {
+            if(route.nodeName() == wanted)
+                vectorFound += route.get<int>("port");
+        }
+    }
+    report("ConfigNode::getChildrenOf", vectorStopwatch.seconds(), 0);
+    size_t rangeFound = 0;
+    Stopwatch rangeStopwatch;
+    for(unsigned round = 0; round != rounds; ++round)
+    {
+        BOOST_FOREACH(const jet::ConfigNodeView& route, config.view().children(routesPath))
+        {
+            if(route.rawName() == wanted)
+                rangeFound += route.get<int>("port");
+        }
+    }
+    report("ConfigNodeView::children", rangeStopwatch.seconds(), 0);
+    EXPECT_EQ(vectorFound, rangeFound);
+}
+
+TEST(Benchmark, HotReload)
+{
+    namespace FS = boost::filesystem;
+    const unsigned scale = benchmarkScale();
+    const FS::path directory(temporaryPath("JetConfigHotReloadBenchmark-%%%%-%%%%-%%%%.d"));
+    FS::create_directory(directory);
+    const std::string filename((directory / "fleet.xml").string());
+    const std::string xml(makeXmlSource(100 * scale, 4, 20));
+    std::ofstream(filename.c_str()) << xml;
+    jet::ConfigReloader reloader("app42", "i1", std::vector<std::string>(1, filename), jet::ConfigSource::xml, 20);
+    const boost::shared_ptr<const jet::Config> first(reloader.get());
+    std::ofstream(filename.c_str()) << xml;
+    for(unsigned i = 0; i != 1000 && !reloader.statistics().reloads; ++i)
+        boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+    const jet::ConfigReloader::Statistics statistics(reloader.statistics());
+    report("ConfigReloader rebuild", statistics.lastRebuildSeconds, xml.size());
+    report("ConfigReloader latency (debounce 20ms)", statistics.lastLatencySeconds, xml.size());
+    Stopwatch getStopwatch;
+    size_t found = 0;
+    for(unsigned i = 0; i != 100000 * scale; ++i)
+        found += reloader.get() != first;
+    report("ConfigReloader::get", getStopwatch.seconds(), 0);
+    FS::remove_all(directory);
+    EXPECT_EQ(statistics.reloads, 1u);
+    EXPECT_EQ(found, 100000 * scale);
+}
+
+namespace
+{
+
+void readSharedConfig(const jet::ConfigSnapshots& snapshots, const jet::ConfigPath& path, unsigned reads, long& sum)
+{
+    for(unsigned i = 0; i != reads; ++i)
+        sum += snapshots.get()->get<int>(path);
+}
+
+void readSnapshots(jet::ConfigSnapshots& snapshots, const jet::ConfigPath& path, unsigned reads, long& sum)
+{
+    jet::ConfigSnapshots::Reader reader(snapshots);
+    for(unsigned i = 0; i != reads; ++i)
+    {
+        const jet::ConfigSnapshots::Snapshot config(reader);
+        sum += config->get<int>(path);
+    }
+}
+
+template<typename Read>
+double readConcurrently(Read read, jet::ConfigSnapshots& snapshots, const jet::ConfigPath& path, unsigned threads,
+    unsigned reads)
+{
+    std::vector<long> sums(threads * 16);//...sums of threads are on different cache lines
+    Stopwatch stopwatch;
+    boost::thread_group readers;
+    for(unsigned i = 0; i != threads; ++i)
+        readers.create_thread(boost::bind(read, boost::ref(snapshots), boost::cref(path), reads, boost::ref(sums[i * 16])));
+    readers.join_all();
+    const double seconds = stopwatch.seconds();
+    long sum = 0;
+    BOOST_FOREACH(long threadSum, sums)
+        sum += threadSum;
+    EXPECT_EQ(sum, 1001L * threads * reads);
+    return seconds;
+}
+
+}//anonymous namespace
+
+TEST(Benchmark, MultiThreadedRead)
+{
+    const unsigned scale = benchmarkScale();
+    const unsigned reads = 200000 * scale;
+    const boost::shared_ptr<jet::Config> config(new jet::Config("app42", "i1"));
+    *config << jet::ConfigSource(makeXmlSource(100, 4, 20), "fleet.xml") << jet::lock;
+    jet::ConfigSnapshots snapshots(config);
+    const jet::ConfigPath path("port");
+    const unsigned maxThreads = std::min(64u, std::max(1u, boost::thread::hardware_concurrency()));
+    for(unsigned threads = 1; threads <= maxThreads; threads *= 2)
+    {//...every thread makes the same number of reads, so time stays the same when readers scale linearly
+        const std::string suffix(" (" + boost::lexical_cast<std::string>(threads) + " threads)");
+        report("ConfigSnapshots::get" + suffix, readConcurrently(&readSharedConfig, snapshots, path, threads, reads), 0);
+        report("ConfigSnapshots::Snapshot" + suffix, readConcurrently(&readSnapshots, snapshots, path, threads, reads), 0);
+    }
+}
+
+namespace
+{
+
+//...application with 'routes' routes and a few other sections, route 'changed' has a different url
+boost::shared_ptr<const jet::Config> makeRoutesConfig(unsigned routes, unsigned changed)
+{
+    std::ostringstream strm;
+    strm << "<config>\n  <app>\n    <database host='db' port='5432'/>\n    <routes>\n";
+    for(unsigned route = 0; route != routes; ++route)
+        strm << "      <route" << route << " url='/r" << route << (route == changed ? "/v2" : "") << "' timeout='10'/>\n";
+    strm << "    </routes>\n  </app>\n</config>\n";
+    const boost::shared_ptr<jet::Config> config(new jet::Config("app"));
+    *config << jet::ConfigSource(strm.str(), "routes.xml") << jet::lock;
+    return config;
+}
+
+void countChange(size_t& changes, const jet::ConfigChange&)
+{
+    ++changes;
+}
+
+}//anonymous namespace
+
+TEST(Benchmark, SubscriptionDiff)
+{
+    const unsigned scale = benchmarkScale();
+    const unsigned routes = 20000 * scale;
+    const boost::shared_ptr<const jet::Config> previous(makeRoutesConfig(routes, routes));
+    const boost::shared_ptr<const jet::Config> current(makeRoutesConfig(routes, routes / 2));
+    Stopwatch leafStopwatch;
+    size_t leafChanges = 0;
+    for(unsigned i = 0; i != 10; ++i)
+    {//...every leaf is compared, it's what a component would do without subscriptions
+        std::vector<std::pair<std::string, std::string> > previousProperties(previous->getProperties());
+        std::vector<std::pair<std::string, std::string> > currentProperties(current->getProperties());
+        std::sort(previousProperties.begin(), previousProperties.end());
+        std::sort(currentProperties.begin(), currentProperties.end());
+        for(size_t property = 0; property != currentProperties.size(); ++property)
+            leafChanges += previousProperties[property] != currentProperties[property];
+    }
+    report("compare all properties x 10", leafStopwatch.seconds(), 0);
+    jet::ConfigSubscriptions subscriptions;
+    size_t changes = 0;
+    subscriptions.subscribe("database", boost::bind(&countChange, boost::ref(changes), _1));
+    subscriptions.subscribe("routes.*", boost::bind(&countChange, boost::ref(changes), _1));
+    Stopwatch diffStopwatch;
+    for(unsigned i = 0; i != 10; ++i)
+        subscriptions.notify(*previous, *current);
+    report("ConfigSubscriptions::notify x 10", diffStopwatch.seconds(), 0);
+    EXPECT_EQ(leafChanges, 10u);
+    EXPECT_EQ(changes, 10u);
+}
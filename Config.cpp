@@ -8,14 +8,32 @@
 
 #include "Config.hpp"
 #include "ConfigSourceImpl.hpp"
+#include "ConfigImage.hpp"
+#include "ConfigPathIndex.hpp"
 #include "ConfigError.hpp"
+#include "ConfigWriter.hpp"
 #include <boost/property_tree/exceptions.hpp>
-#include <boost/property_tree/xml_parser.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/move/utility_core.hpp>
+#include <boost/range/reference.hpp>
+#include <boost/type_traits/remove_reference.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
+#include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <algorithm>
+#include <deque>
+#include <list>
 #include <sstream>
+#include <vector>
 
 //#include <iostream>
 //using std::cout;
@@ -64,11 +82,484 @@ inline std::string addPath(const std::string& lhs, const std::string& rhs)
     return res;
 }
 
+inline const Tree* findChild(const Tree& tree, const std::string& name)
+{
+    const CAssocIter iter(tree.find(name));
+    return tree.not_found() == iter ? 0 : &iter->second;
+}
+
+inline Tree* findChild(Tree& tree, const std::string& name)
+{
+    const AssocIter iter(tree.find(name));
+    return tree.not_found() == iter ? 0 : &iter->second;
+}
+
+//...Merges many sources at once with the same result as merging them one by one with MergeProcessor.
+//...Children of a node are grouped by name over all sources, so every group goes through the whole
+//...list of sources in one pass, and groups of top level nodes are merged concurrently. Every error is
+//...tagged with its position in the sequential merge, so the same error as there is the one reported.
+class BulkMergeProcessor: boost::noncopyable
+{
+public:
+    //...node of a source which is merged into a target node
+    struct Contribution
+    {
+        const Tree* tree;
+        size_t source;
+        const Contribution* parent;
+        size_t position;//...of the tree among children of the parent, or of the target for the top level
+    };
+    typedef std::vector<Contribution> Contributions;
+    BulkMergeProcessor(const std::string& configName, const std::vector<const std::string*>& sourceNames):
+        configName_(configName),
+        sourceNames_(sourceNames),
+        next_(0)
+    {}
+    static size_t maxWorkerCount() { return std::max(1u, boost::thread::hardware_concurrency()); }
+    //...small merges are done by one thread, starting workers costs more than they save
+    static size_t workerCount(size_t taskCount, size_t nodeCount)
+    {
+        return std::min<size_t>(
+            std::min<size_t>(maxWorkerCount(), taskCount),
+            std::max<size_t>(1, nodeCount / MIN_NODES_PER_WORKER));
+    }
+    //...contributions of every target are in the order of sources, targets are in the order of merge.
+    //...Targets are left unchanged if it throws, new nodes are added to them by commit
+    void merge(const std::vector<Tree*>& targets, const std::vector<Contributions>& contributions)
+    {
+        assert(targets.size() == contributions.size());
+        groups_.resize(targets.size());
+        size_t nodeCount = 0;
+        for(size_t target = 0; target != targets.size(); ++target)
+        {
+            makeGroups(contributions[target], groups_[target]);
+            for(size_t group = 0; group != groups_[target].size(); ++group)
+            {
+                tasks_.push_back(Task(targets[target], &contributions[target], &groups_[target][group]));
+                BOOST_FOREACH(const Entry& entry, groups_[target][group].entries)
+                    nodeCount += 1 + entry.child->second.size();
+            }
+        }
+        targets_ = targets;
+        const size_t workers = workerCount(tasks_.size(), nodeCount);
+        if(workers > 1)
+        {
+            boost::thread_group threads;
+            for(size_t i = 1; i != workers; ++i)
+                threads.create_thread(boost::bind(&BulkMergeProcessor::work, this));
+            work();
+            threads.join_all();
+        }
+        else
+            work();
+        boost::optional<Error> error;
+        BOOST_FOREACH(const Task& task, tasks_)
+            updateError(error, task.error);
+        if(error)
+        {
+            rollback();
+            throw ConfigError(error->message);
+        }
+    }
+    void commit()
+    {
+        for(size_t target = 0; target != targets_.size(); ++target)
+        {
+            std::vector<NewNode*> newNodes;
+            BOOST_FOREACH(Task& task, tasks_)
+            {
+                if(targets_[target] != task.target)
+                    continue;
+                BOOST_FOREACH(NewNode& node, task.newNodes)
+                    newNodes.push_back(&node);
+            }
+            appendNewNodes(*targets_[target], newNodes);
+        }
+    }
+    //...only top level nodes which were changed are restored, new nodes aren't added before commit
+    void rollback()
+    {
+        BOOST_FOREACH(Task& task, tasks_)
+        {
+            if(task.original)
+                findChild(*task.target, *task.group->name)->swap(*task.original);
+        }
+    }
+private:
+    struct Entry
+    {
+        size_t contribution;
+        const ValueType* child;
+        size_t position;
+    };
+    struct Group
+    {
+        const std::string* name;
+        std::vector<Entry> entries;//...in the order of contributions
+    };
+    typedef std::vector<Group> Groups;
+    struct NewNode
+    {
+        size_t source;
+        size_t position;
+        const std::string* name;
+        Tree tree;
+    };
+    typedef std::list<NewNode> NewNodes;//...nodes don't move when new ones are added, and empty list costs nothing
+    struct Error
+    {
+        std::vector<size_t> position;//...source, target and positions of nodes down to the failed one
+        std::string message;
+    };
+    struct Task
+    {
+        Task(Tree* target_, const Contributions* contributions_, const Group* group_):
+            target(target_), contributions(contributions_), group(group_)
+        {}
+        Tree* target;
+        const Contributions* contributions;
+        const Group* group;
+        NewNodes newNodes;
+        boost::optional<Error> error;
+        boost::optional<Tree> original;//...the top level node before it was changed
+    };
+    struct NameHash
+    {
+        size_t operator()(const std::string* name) const { return boost::hash_range(name->begin(), name->end()); }
+    };
+    struct NameEqual
+    {
+        bool operator()(const std::string* lhs, const std::string* rhs) const { return *lhs == *rhs; }
+    };
+    typedef boost::unordered_map<const std::string*, size_t, NameHash, NameEqual> GroupIndex;
+    static bool isEarlier(const NewNode* lhs, const NewNode* rhs)
+    {
+        return lhs->source < rhs->source || (lhs->source == rhs->source && lhs->position < rhs->position);
+    }
+    static void updateError(boost::optional<Error>& first, const boost::optional<Error>& error)
+    {
+        if(error && (!first || error->position < first->position))
+            first = error;
+    }
+    static void makeGroups(const Contributions& contributions, Groups& groups)
+    {
+        GroupIndex index;
+        for(size_t contribution = 0; contribution != contributions.size(); ++contribution)
+        {
+            size_t position = 0;
+            size_t next = 0;//...layered sources usually have the same children in the same order
+            BOOST_FOREACH(const ValueType& child, *contributions[contribution].tree)
+            {
+                const Entry entry = { contribution, &child, position++ };
+                if(INSTANCE_NODE_NAME == child.first)
+                    continue;
+                size_t group = next;
+                if(groups.size() == group || *groups[group].name != child.first)
+                {
+                    const std::pair<GroupIndex::iterator, bool> inserted(
+                        index.insert(std::make_pair(&child.first, groups.size())));
+                    if(inserted.second)
+                    {
+                        groups.push_back(Group());
+                        groups.back().name = &child.first;
+                    }
+                    group = inserted.first->second;
+                }
+                groups[group].entries.push_back(entry);
+                next = group + 1;
+            }
+        }
+    }
+    static void appendNewNodes(Tree& target, std::vector<NewNode*>& newNodes)
+    {//...new nodes are added in the same order as every source adds them
+        std::sort(newNodes.begin(), newNodes.end(), &BulkMergeProcessor::isEarlier);
+        BOOST_FOREACH(NewNode* node, newNodes)
+        {
+            target.push_back(ValueType(*node->name, Tree()));
+            target.back().second.swap(node->tree);
+        }
+    }
+    void work()
+    {
+        for(size_t index = nextIndex(); index != tasks_.size(); index = nextIndex())
+        {
+            Task& task(tasks_[index]);
+            mergeGroup(*task.target, *task.contributions, *task.group, task.newNodes, task.error, &task.original);
+        }
+    }
+    size_t nextIndex()
+    {
+        const boost::lock_guard<boost::mutex> guard(mutex_);
+        if(tasks_.size() != next_)
+            return next_++;
+        return next_;
+    }
+    void mergeChildren(Tree& target, const Contributions& contributions, boost::optional<Error>& error) const
+    {
+        Groups groups;
+        makeGroups(contributions, groups);
+        NewNodes newNodes;
+        BOOST_FOREACH(const Group& group, groups)
+        {
+            boost::optional<Error> groupError;
+            mergeGroup(target, contributions, group, newNodes, groupError, 0);
+            updateError(error, groupError);
+        }
+        if(error)
+            return;
+        std::vector<NewNode*> nodes;
+        BOOST_FOREACH(NewNode& node, newNodes)
+            nodes.push_back(&node);
+        appendNewNodes(target, nodes);
+    }
+    //...the same steps as MergeProcessor does for the name with every source, but consecutive values
+    //...which override the node are assigned only once and merges into the node go down in one pass.
+    //...'original' is given for top level nodes, it keeps the existing node before its first change
+    void mergeGroup(
+        Tree& target,
+        const Contributions& contributions,
+        const Group& group,
+        NewNodes& newNodes,
+        boost::optional<Error>& error,
+        boost::optional<Tree>* original) const
+    {
+        const std::string& name(*group.name);
+        size_t count = target.count(name);
+        Tree* node = 0;
+        if(1 == count)
+            node = &target.find(name)->second;
+        else
+            original = 0;//...nodes which are added aren't in the target until commit
+        const Tree* value = 0;//...the last value which overrides the node
+        Contributions merges;//...consecutive merges into the node
+        for(size_t begin = 0; begin != group.entries.size();)
+        {
+            const Entry& entry(group.entries[begin]);
+            size_t end = begin + 1;
+            while(group.entries.size() != end && entry.contribution == group.entries[end].contribution)
+                ++end;
+            const Contribution& contribution(contributions[entry.contribution]);
+            if(count > 1 || (count > 0 && end - begin > 1))
+            {//...ambiguous merge, but merges from previous sources could fail before
+                if(!merges.empty())
+                    mergeChildren(keep(*node, original), merges, error);
+                if(!error)
+                    error = makeError(contribution, entry.position, name);
+                return;
+            }
+            if(0 == count)
+            {
+                for(size_t i = begin; i != end; ++i)
+                {
+                    const NewNode newNode = { contribution.source, group.entries[i].position, &name, Tree() };
+                    newNodes.push_back(newNode);
+                    newNodes.back().tree = group.entries[i].child->second;
+                }
+                count = end - begin;
+                if(1 == count)
+                    node = &newNodes.back().tree;
+            }
+            else if(entry.child->second.empty())
+            {
+                if(!merges.empty())
+                {
+                    mergeChildren(keep(*node, original), merges, error);
+                    if(error)
+                        return;
+                    merges.clear();
+                }
+                value = &entry.child->second;
+            }
+            else
+            {
+                if(value)
+                {
+                    assign(*node, *value, original);
+                    value = 0;
+                }
+                const Contribution merge = { &entry.child->second, contribution.source, &contribution, entry.position };
+                merges.push_back(merge);
+            }
+            begin = end;
+        }
+        if(!merges.empty())
+            mergeChildren(keep(*node, original), merges, error);
+        else if(value)
+            assign(*node, *value, original);
+    }
+    static Tree& keep(Tree& node, boost::optional<Tree>*& original)
+    {
+        if(original)
+        {
+            *original = node;
+            original = 0;
+        }
+        return node;
+    }
+    //...the node is overridden, so the existing one is moved out instead of being copied
+    static void assign(Tree& node, const Tree& value, boost::optional<Tree>*& original)
+    {
+        if(original)
+        {
+            *original = Tree();
+            (*original)->swap(node);
+            original = 0;
+        }
+        node = value;
+    }
+    Error makeError(const Contribution& contribution, size_t position, const std::string& name) const
+    {
+        Error error;
+        error.position.push_back(position);
+        for(const Contribution* iter = &contribution; iter; iter = iter->parent)
+            error.position.push_back(iter->position);
+        error.position.push_back(contribution.source);
+        std::reverse(error.position.begin(), error.position.end());
+        error.message = str(
+            boost::format("Can't do ambiguous merge of node '%1%' from config source '%2%' to config '%3%'") %
+            name %
+            *sourceNames_[contribution.source] %
+            configName_);
+        return error;
+    }
+    //...
+    static const size_t MIN_NODES_PER_WORKER = 1024;
+    const std::string configName_;
+    const std::vector<const std::string*>& sourceNames_;
+    std::vector<Tree*> targets_;
+    std::vector<Groups> groups_;
+    std::deque<Task> tasks_;
+    size_t next_;
+    boost::mutex mutex_;
+};
+
+//...Changes of top level nodes of config made by merge of many sources one by one, so the merge can be rolled
+//...back. Existing node is kept before its first change, and nodes which are added are dropped from the end
+class MergeJournal: boost::noncopyable
+{
+public:
+    void track(Tree& target)
+    {
+        for(std::vector<std::pair<Tree*, size_t> >::const_iterator iter = sizes_.begin(); sizes_.end() != iter; ++iter)
+        {
+            if(&target == iter->first)
+                return;
+        }
+        sizes_.push_back(std::make_pair(&target, target.size()));
+    }
+    //...node which is overridden is moved out instead of being copied
+    void keep(Tree& node, bool isOverridden)
+    {
+        if(!changed_.insert(&node).second)
+            return;
+        originals_.push_back(std::make_pair(&node, Tree()));
+        if(isOverridden)
+            originals_.back().second.swap(node);
+        else
+            originals_.back().second = node;
+    }
+    void add(Tree& node)
+    {
+        changed_.insert(&node);
+    }
+    void rollback()
+    {
+        for(std::deque<std::pair<Tree*, Tree> >::reverse_iterator iter = originals_.rbegin(); originals_.rend() != iter; ++iter)
+            iter->first->swap(iter->second);
+        for(std::vector<std::pair<Tree*, size_t> >::const_iterator iter = sizes_.begin(); sizes_.end() != iter; ++iter)
+        {
+            while(iter->first->size() != iter->second)
+                iter->first->pop_back();
+        }
+    }
+private:
+    std::vector<std::pair<Tree*, size_t> > sizes_;//...of targets before merge
+    std::deque<std::pair<Tree*, Tree> > originals_;//...nodes don't move when new ones are added
+    boost::unordered_set<const Tree*> changed_;
+};
+
+//...Values of properties of locked config converted to types which were requested. Every node has a list
+//...of values of different types, values are only added and are never changed, so readers don't take locks.
+//...If two threads convert the same value at the same time both values are added, and the first one is found
+class ValueCache: boost::noncopyable
+{
+public:
+    explicit ValueCache(size_t nodeCount):
+        values_(new boost::atomic<Value*>[nodeCount]),
+        nodeCount_(nodeCount)
+    {
+        for(size_t node = 0; node != nodeCount_; ++node)
+            values_[node].store(0, boost::memory_order_relaxed);
+    }
+    ~ValueCache()
+    {
+        for(size_t node = 0; node != nodeCount_; ++node)
+        {
+            for(Value* value = values_[node].load(boost::memory_order_relaxed); value;)
+            {
+                Value* const next = value->next;
+                delete value;
+                value = next;
+            }
+        }
+    }
+    const boost::any* find(size_t node, const std::type_info& type) const
+    {
+        for(const Value* value = values_[node].load(boost::memory_order_acquire); value; value = value->next)
+        {
+            if(value->value.type() == type)
+                return &value->value;
+        }
+        return 0;
+    }
+    const boost::any& add(size_t node, const boost::any& value)
+    {
+        Value* head = values_[node].load(boost::memory_order_relaxed);
+        Value* const added = new Value(value, head);
+        //...'next' isn't passed as expected value, it would be written after the value is seen by readers
+        while(!values_[node].compare_exchange_weak(head, added, boost::memory_order_release, boost::memory_order_relaxed))
+            added->next = head;
+        return added->value;
+    }
+private:
+    struct Value
+    {
+        Value(const boost::any& value, Value* next): value(value), next(next) {}
+        const boost::any value;
+        Value* next;
+    };
+    //...
+    boost::scoped_array<boost::atomic<Value*> > values_;
+    const size_t nodeCount_;
+};
+
+//...Hash of value and children of every node of the image, names and order of children are included. Strings
+//...are hashed, not their offsets in the image, so equal subtrees of different configs have equal hashes
+void hashContents(const ConfigImage& image, std::vector<ConfigPathIndex::Hash>& hashes)
+{
+    hashes.resize(image.nodeCount());
+    for(size_t i = hashes.size(); i--;)
+    {//...children are after their parent in the image
+        const ConfigImage::Node& node(*(&image.root() + i));
+        ConfigPathIndex::Hash hash = ConfigPathIndex::emptyPathHash();
+        hash = ConfigPathIndex::hash(hash, reinterpret_cast<const char*>(&node.dataSize), sizeof(node.dataSize));
+        hash = ConfigPathIndex::hash(hash, image.dataBegin(node), node.dataSize);
+        for(const ConfigImage::Node* child = image.childrenBegin(node); image.childrenEnd(node) != child; ++child)
+        {
+            hash = ConfigPathIndex::hash(hash, reinterpret_cast<const char*>(&child->nameSize), sizeof(child->nameSize));
+            hash = ConfigPathIndex::hash(hash, image.nameBegin(*child), child->nameSize);
+            const ConfigPathIndex::Hash childHash = hashes[child - &image.root()];
+            hash = ConfigPathIndex::hash(hash, reinterpret_cast<const char*>(&childHash), sizeof(childHash));
+        }
+        hashes[i] = hash;
+    }
+}
+
 }//anonymous namespace
 
 const ConfigLock lock = {};
 
-class ConfigNode::Impl: boost::noncopyable
+class ConfigNode::Impl: public boost::enable_shared_from_this<ConfigNode::Impl>, boost::noncopyable
 {
 public:
     Impl(const std::string& appName, const std::string& instanceName):
@@ -90,32 +581,109 @@ public:
     const std::string& instanceName() const { return instanceName_; }
     void merge(const ConfigSource::Impl& source)
     {
-        if(isLocked_)
-            throw ConfigError(str(boost::format("Config '%1%' is locked") % name()));
-        const Tree& otherConfig(source.getRoot().front().second);
-        
-        {//...merge shared attributes (if found)
-            const CAssocIter sharedIter = otherConfig.find(SHARED_NODE_NAME);
-            if(otherConfig.not_found() != sharedIter)
-                MergeProcessor(name(), source.name()).merge(getSharedNode(), sharedIter->second);
+        checkMerge(source);
+        merge(source.getRoot().front().second, source.name());
+    }
+    //...subtrees of the source are moved into the config, source is left with empty 'config' node
+    void consume(ConfigSource::Impl& source)
+    {
+        checkMerge(source);
+        merge(source.getRoot().front().second, source.name());
+        source.getRoot().front().second.clear();
+    }
+    //...the same result as merging of sources one by one, but config is left unchanged if merge fails
+    void merge(const std::vector<const ConfigSource::Impl*>& sources)
+    {
+        if(BulkMergeProcessor::maxWorkerCount() < 2)
+        {//...grouping of nodes pays off only with many threads, one thread merges sources one by one faster
+            mergeOneByOne(sources);
+            return;
         }
-        const CAssocIter appIter = otherConfig.find(appName());
-        if(appIter == otherConfig.not_found())
+        std::vector<const std::string*> sourceNames;
+        std::vector<BulkMergeProcessor::Contributions> contributions(instanceName().empty() ? 2 : 3);
+        boost::optional<ConfigError> sourceError;
+        BOOST_FOREACH(const ConfigSource::Impl* source, sources)
+        {
+            try
+            {
+                checkMerge(*source);
+            }
+            catch(const ConfigError& error)
+            {//...following sources are not merged, but merge errors of previous ones go first
+                sourceError = error;
+                break;
+            }
+            const Tree& otherConfig(source->getRoot().front().second);
+            const BulkMergeProcessor::Contribution shared = { findChild(otherConfig, SHARED_NODE_NAME), sourceNames.size(), 0, 0 };
+            if(shared.tree)
+                contributions[0].push_back(shared);
+            if(const Tree* app = findChild(otherConfig, appName()))
+            {
+                const BulkMergeProcessor::Contribution self = { app, sourceNames.size(), 0, 1 };
+                contributions[1].push_back(self);
+                const Tree* instanceRoot = instanceName().empty() ? 0 : findChild(*app, INSTANCE_NODE_NAME);
+                const BulkMergeProcessor::Contribution instance = {
+                    instanceRoot ? findChild(*instanceRoot, instanceName()) : 0, sourceNames.size(), 0, 2 };
+                if(instance.tree)
+                    contributions[2].push_back(instance);
+            }
+            sourceNames.push_back(&source->name());
+        }
+        if(sourceNames.empty())
+        {//...nothing is merged, and the config can be locked
+            if(sourceError)
+                throw *sourceError;
             return;
-        MergeProcessor(name(), source.name()).merge(getSelfNode(), appIter->second);
-        if(!instanceName().empty())
-        {//...merge instance
-            const CAssocIter instanceRootIter = appIter->second.find(INSTANCE_NODE_NAME);
-            if(appIter->second.not_found() != instanceRootIter)
+        }
+        size_t entryCount = 0;
+        size_t nodeCount = 0;
+        BOOST_FOREACH(const BulkMergeProcessor::Contributions& targetContributions, contributions)
+        {
+            BOOST_FOREACH(const BulkMergeProcessor::Contribution& contribution, targetContributions)
             {
-                const CAssocIter instanceIter = instanceRootIter->second.find(instanceName());
-                if(instanceRootIter->second.not_found() != instanceIter)
+                BOOST_FOREACH(const ValueType& child, *contribution.tree)
                 {
-                    MergeProcessor(name(), source.name()).merge(
-                        getInstanceNode(), instanceIter->second);
+                    ++entryCount;
+                    nodeCount += 1 + child.second.size();
                 }
             }
         }
+        if(BulkMergeProcessor::workerCount(entryCount, nodeCount) < 2)
+        {//...the merge is too small for many threads, errors of sources are found again one by one
+            mergeOneByOne(sources);
+            return;
+        }
+        std::vector<Tree*> targets;
+        targets.push_back(&getSharedNode());
+        targets.push_back(&getSelfNode());
+        if(!instanceName().empty())
+            targets.push_back(&getInstanceNode());
+        BulkMergeProcessor processor(name(), sourceNames);
+        processor.merge(targets, contributions);
+        if(sourceError)
+        {
+            processor.rollback();
+            throw *sourceError;
+        }
+        processor.commit();
+    }
+    //...the same as merge of every source, but changes are rolled back if any of them fails
+    void mergeOneByOne(const std::vector<const ConfigSource::Impl*>& sources)
+    {
+        MergeJournal journal;
+        try
+        {
+            BOOST_FOREACH(const ConfigSource::Impl* source, sources)
+            {
+                checkMerge(*source);
+                merge(source->getRoot().front().second, source->name(), &journal);
+            }
+        }
+        catch(...)
+        {
+            journal.rollback();
+            throw;
+        }
     }
     void lock()
     {
@@ -132,21 +700,134 @@ public:
         //...erase shared and (optionally) instance node
         config_->erase(SHARED_NODE_NAME);
         config_->erase(instanceName());
+        //...locked config is frozen into the image, ptree isn't needed anymore
+        image_.reset(new ConfigImage(config_->front().second, appName(), instanceName()));
+        index_.reset(new ConfigPathIndex(*image_));
+        values_.reset(new ValueCache(image_->nodeCount()));
+        hashContents(*image_, contentHashes_);
+        config_->clear();
         isLocked_ = true;
     }
-    const Tree& getConfigNode() const
+    bool isLocked() const { return isLocked_; }
+    const ConfigImage& getImage() const
     {
         if(!isLocked_)
             throw ConfigError(str(
                 boost::format("Initialization of config '%1%' is not finished") % name()));
-        return *config_;
+        return *image_;
+    }
+    //...zero node is the root, it's used by handles which were copied before lock
+    const ConfigImage::Node& getNode(const ConfigImage::Node* node) const
+    {
+        const ConfigImage& image(getImage());
+        return node ? *node : image.root();
+    }
+    const ConfigPathIndex& getIndex() const
+    {
+        getImage();
+        return *index_;
+    }
+    //...node is found by the index with one probe, and by keys of the path if it isn't there
+    const ConfigImage::Node* findPath(
+        const ConfigImage::Node& base,
+        ConfigPathIndex::Hash hash,
+        const std::string& path) const
+    {
+        const ConfigImage::Node* found = findIndexed(base, hash, path.data(), path.size());
+        return found ? found : image_->findPath(base, path);
+    }
+    const ConfigImage::Node* findIndexed(
+        const ConfigImage::Node& base,
+        ConfigPathIndex::Hash hash,
+        const char* path,
+        size_t size) const
+    {
+        const ConfigImage::Node* found = index_->find(hash);
+        return found && index_->isPath(base, *found, path, size) ? found : 0;
+    }
+    const boost::any* findCachedValue(const ConfigImage::Node& node, const std::type_info& type) const
+    {
+        return values_->find(&node - &image_->root(), type);
+    }
+    const boost::any& cacheValue(const ConfigImage::Node& node, const boost::any& value)
+    {
+        return values_->add(&node - &image_->root(), value);
+    }
+    ConfigPathIndex::Hash contentHash(const ConfigImage::Node& node) const
+    {
+        return contentHashes_[&node - &image_->root()];
+    }
+    static ConfigPathIndex::Hash pathHash(const std::string& path)
+    {
+        return ConfigPathIndex::hash(ConfigPathIndex::emptyPathHash(), path.data(), path.size());
+    }
+    //...hash of node path is continued with relative path, the root has empty path
+    static ConfigPathIndex::Hash pathHash(ConfigPathIndex::Hash nodeHash, const char* path, size_t size)
+    {
+        if(ConfigPathIndex::emptyPathHash() != nodeHash && size)
+            nodeHash = ConfigPathIndex::hash(nodeHash, ".", 1);
+        return ConfigPathIndex::hash(nodeHash, path, size);
+    }
+    void saveSnapshot(const std::string& filename) const
+    {
+        getImage().save(filename);
+    }
+    void loadSnapshot(const std::string& filename)
+    {
+        if(isLocked_)
+            throw ConfigError(str(boost::format("Config '%1%' is locked") % name()));
+        boost::scoped_ptr<ConfigImage> image(new ConfigImage(filename));
+        if(image->appName() != appName() || image->instanceName() != instanceName())
+            throw ConfigError(str(
+                boost::format("Config snapshot '%1%' is created for config '%2%', not for '%3%'") %
+                filename %
+                composeName(image->appName(), image->instanceName()) %
+                name()));
+        index_.reset(new ConfigPathIndex(*image));
+        values_.reset(new ValueCache(image->nodeCount()));
+        hashContents(*image, contentHashes_);
+        image_.swap(image);
+        config_->clear();//...all data is in the image now
+        isLocked_ = true;
     }
     void print(std::ostream& os) const
     {
-        PT::write_xml(os, root_, PT::xml_writer_make_settings(' ', 2));
+        XmlWriter(os, true).write(root_);
     }
     std::string name() const { return composeName(appName(), instanceName()); }
 private:
+    void checkMerge(const ConfigSource::Impl& source) const
+    {
+        if(isLocked_)
+            throw ConfigError(str(boost::format("Config '%1%' is locked") % name()));
+        const ConfigSource::Filter* filter = source.filter();
+        if(filter && (filter->appName != appName() || filter->instanceName != instanceName()))
+            throw ConfigError(str(
+                boost::format("Config source '%1%' is filtered for config '%2%' and can't be merged into config '%3%'") %
+                source.name() %
+                composeName(filter->appName, filter->instanceName) %
+                name()));
+    }
+    //...SourceTree is 'const Tree' for copying merge or 'Tree' for the one which moves subtrees
+    template<class SourceTree>
+    void merge(SourceTree& otherConfig, const std::string& sourceName, MergeJournal* journal = 0)
+    {
+        //...merge shared attributes (if found)
+        if(SourceTree* shared = findChild(otherConfig, SHARED_NODE_NAME))
+            MergeProcessor(name(), sourceName).merge(getSharedNode(), *shared, journal);
+        SourceTree* app = findChild(otherConfig, appName());
+        if(!app)
+            return;
+        MergeProcessor(name(), sourceName).merge(getSelfNode(), *app, journal);
+        if(!instanceName().empty())
+        {//...merge instance
+            if(SourceTree* instanceRoot = findChild(*app, INSTANCE_NODE_NAME))
+            {
+                if(SourceTree* instance = findChild(*instanceRoot, instanceName()))
+                    MergeProcessor(name(), sourceName).merge(getInstanceNode(), *instance, journal);
+            }
+        }
+    }
     class MergeProcessor
     {
     public:
@@ -154,10 +835,16 @@ private:
             configName_(configName),
             sourceName_(sourceName)
         {}
-        void merge(Tree& to, const Tree& from) const
+        //...'from' is const for copying merge, otherwise its subtrees are moved and it must be discarded after.
+        //...Changes of children of 'to' are written to journal if it's given
+        template<class SourceTree>
+        void merge(Tree& to, SourceTree& from, MergeJournal* journal = 0) const
         {
-            Tree newChildren;
-            BOOST_FOREACH(const ValueType& node, from)
+            if(journal)
+                journal->track(to);
+            typedef typename boost::remove_reference<typename boost::range_reference<SourceTree>::type>::type SourceValue;
+            std::vector<SourceValue*> newChildren;
+            BOOST_FOREACH(SourceValue& node, from)
             {
                 const std::string& mergeName(node.first);
                 if(INSTANCE_NODE_NAME == mergeName)
@@ -173,30 +860,36 @@ private:
                             sourceName_ %
                             configName_));
                 }
-                const Tree& mergeTree(node.second);
                 const AssocIter iter(to.find(mergeName));
                 if(iter == to.not_found())
                 {
-                    newChildren.push_back(node);
+                    newChildren.push_back(&node);
                 }
-                else if(mergeTree.empty())
+                else if(node.second.empty())
                 {
-                    iter->second = mergeTree;
+                    if(journal)
+                        journal->keep(iter->second, true);
+                    assign(iter->second, node.second);
                 }
                 else
                 {
-                    merge(iter->second, mergeTree);
+                    if(journal)
+                        journal->keep(iter->second, false);
+                    merge(iter->second, node.second);
                 }
             }
-            BOOST_FOREACH(ValueType& node, newChildren)
+            BOOST_FOREACH(SourceValue* node, newChildren)
             {
-                const std::string& name(node.first);
-                to.push_back(Tree::value_type(name, Tree()));
-                node.second.swap(to.back().second);
+                to.push_back(Tree::value_type(node->first, Tree()));
+                assign(to.back().second, node->second);
+                if(journal)
+                    journal->add(to.back().second);
             }
-
         }
     private:
+        static void assign(Tree& to, const Tree& from) { to = from; }
+        static void assign(Tree& to, Tree& from) { to.swap(from); }
+        //...
         const std::string configName_;
         const std::string& sourceName_;
     };
@@ -237,27 +930,31 @@ private:
     bool isLocked_;
     Tree root_;
     Tree* config_;
+    boost::scoped_ptr<ConfigImage> image_;
+    boost::scoped_ptr<ConfigPathIndex> index_;//...must be destroyed before the image
+    boost::scoped_ptr<ValueCache> values_;
+    std::vector<ConfigPathIndex::Hash> contentHashes_;
 };
 
 ConfigNode::ConfigNode(const std::string& appName, const std::string& instanceName):
     impl_(new Impl(boost::trim_copy(appName), boost::trim_copy(instanceName))),
-    treeNode_(0)
+    node_(0)
 {}
 
 ConfigNode::ConfigNode(
     const std::string& path,
     const boost::shared_ptr<Impl>& impl,
-    const void* treeNode):
+    const ConfigImageNode* node):
     path_(path),
     impl_(impl),
-    treeNode_(treeNode)
+    node_(node)
 {
 }
 
 ConfigNode::ConfigNode(const ConfigNode& other):
     path_(other.path_),
     impl_(other.impl_),
-    treeNode_(other.treeNode_)
+    node_(other.node_)
 {
 }
 
@@ -266,7 +963,7 @@ ConfigNode& ConfigNode::operator=(const ConfigNode& other)
     if(&other == this)
         return *this;
     impl_ = other.impl_;
-    treeNode_ = other.treeNode_;
+    node_ = other.node_;
     return *this;
 }
 
@@ -283,32 +980,66 @@ void ConfigNode::merge(const ConfigSource& source)
     impl_->merge(*source.impl_);
 }
 
+void ConfigNode::merge(BOOST_RV_REF(ConfigSource) source)
+{
+    if(source.impl_.unique())
+        impl_->consume(*source.impl_);
+    else//...the same source is used by other handles
+        impl_->merge(*source.impl_);
+}
+
+void ConfigNode::merge(const ConfigSources& sources)
+{
+    std::vector<const ConfigSource::Impl*> impls;
+    impls.reserve(sources.size());
+    BOOST_FOREACH(const ConfigSource& source, sources)
+        impls.push_back(source.impl_.get());
+    impl_->merge(impls);
+}
+
 void ConfigNode::lock()
 {
     impl_->lock();
-    treeNode_ = static_cast<const Tree*>(&(impl_->getConfigNode().front().second));
+    node_ = &impl_->getImage().root();
+}
+
+void ConfigNode::saveSnapshot(const std::string& filename) const
+{
+    impl_->saveSnapshot(filename);
+}
+
+void ConfigNode::loadSnapshot(const std::string& filename)
+{
+    impl_->loadSnapshot(filename);
+    node_ = &impl_->getImage().root();
+}
+
+std::vector<std::pair<std::string, std::string> > ConfigNode::getProperties() const
+{
+    const ConfigImage& image(impl_->getImage());
+    const ConfigPathIndex& index(impl_->getIndex());
+    std::vector<std::pair<std::string, std::string> > res;
+    for(size_t slot = 0; slot != index.count(); ++slot)
+    {
+        const ConfigImage::Node& node(index.node(slot));
+        if(!node.childCount && &image.root() != &node)
+            res.push_back(std::make_pair(index.path(node), image.data(node)));
+    }
+    return res;
 }
 
 void ConfigNode::print(std::ostream& os) const
 {
-    if(treeNode_)
+    if(impl_->isLocked())
     {
+        const ConfigImage::Node& node(impl_->getNode(node_));
         os << '<' << name() << '>';
-        if(!static_cast<const Tree*>(treeNode_)->empty())
+        if(node.childCount)
             os << '\n';
-        {
-            std::stringstream strm;
-            PT::write_xml(
-                strm,
-                *static_cast<const Tree*>(treeNode_),
-                PT::xml_writer_make_settings(' ', 2));
-            std::string firstString;
-            std::getline(strm, firstString);
-            if(firstString.size() > 2 && //...get rid of the first line with <?xml ...?>
-                '<' == firstString[0] && '?' == firstString[1])
-                os << strm.str().substr(firstString.size() + 1);
-            else
-                os << strm.str();
+        {//...image node is copied into ptree to be written
+            Tree tree;
+            impl_->getImage().copyTo(node, tree);
+            XmlWriter(os, true).write(tree);
         }
         os << "</" << name() << ">\n";
     }
@@ -317,42 +1048,34 @@ void ConfigNode::print(std::ostream& os) const
 }
 
 
-std::string ConfigNode::get(const std::string& rawAttrName) const
+ConfigNodeView ConfigNode::view() const
 {
-    impl_->getConfigNode();//...just to check locked state
-    const std::string attrName(boost::trim_copy(rawAttrName));
-    const boost::optional<const Tree&> attrNode(
-        static_cast<const Tree*>(treeNode_)->get_child_optional(attrName));
-    if(!attrNode)
-        throw ConfigError(str(
-            boost::format("Can't find property '%1%' in config '%2%'") %
-            attrName %
-            name()));
-    if(attrNode->empty())
-        return attrNode->data();
-    throw ConfigError(str(
-        boost::format("Node '%1%' is intermidiate node without value") %
-        addPath(name(), attrName)));
+    return ConfigNodeView(*impl_, impl_->getNode(node_), Impl::pathHash(path_));
+}
+
+std::string ConfigNode::get(const std::string& attrName) const
+{
+    return view().get(attrName);
 }
 
 boost::optional<std::string> ConfigNode::getOptional(const std::string& attrName) const
 {
-    impl_->getConfigNode();//...just to check locked state
-    const boost::optional<const Tree&> attrNode(
-        static_cast<const Tree*>(treeNode_)->get_child_optional(boost::trim_copy(attrName)));
+    return view().getOptional(attrName);
+}
 
-    if(attrNode && attrNode->empty())
-        return attrNode->data();
+std::string ConfigNode::get(const ConfigPath& attrPath) const
+{
+    return view().get(attrPath);
+}
 
-    return boost::none;
+boost::optional<std::string> ConfigNode::getOptional(const ConfigPath& attrPath) const
+{
+    return view().getOptional(attrPath);
 }
 
 std::string ConfigNode::get(const std::string& attrName, const std::string& defaultValue) const
 {
-    boost::optional<std::string> value(getOptional(attrName));
-    if(value)
-        return *value;
-    return defaultValue;
+    return view().get(attrName, defaultValue);
 }
 
 ConfigNode ConfigNode::getNode(const std::string& path) const
@@ -366,18 +1089,40 @@ ConfigNode ConfigNode::getNode(const std::string& path) const
         path));
 }
 
+ConfigNode ConfigNode::getNode(const ConfigPath& path) const
+{
+    boost::optional<ConfigNode> optChild(getNodeOptional(path));
+    if(optChild)
+        return *optChild;
+    throw ConfigError(str(
+        boost::format("Config '%1%' doesn't have child '%2%'") %
+        name() %
+        path.str()));
+}
+
+boost::optional<ConfigNode> ConfigNode::getNodeOptional(const ConfigPath& path) const
+{
+    const ConfigImage::Node* node = view().findNode(path);
+    if(node)
+    {
+        return ConfigNode(
+            addPath(path_, path.str()),
+            impl_,
+            node);
+    }
+    return boost::none;
+}
+
 boost::optional<ConfigNode> ConfigNode::getNodeOptional(const std::string& rawPath) const
 {
-    impl_->getConfigNode();//...just to check locked state
     const std::string path(boost::trim_copy(rawPath));
-    const boost::optional<const Tree&> node(
-        static_cast<const Tree*>(treeNode_)->get_child_optional(path));
+    const ConfigImage::Node* node = view().findNode(path);
     if(node)
     {
         return ConfigNode(
             addPath(path_, path),
             impl_,
-            &(*node));
+            node);
     }
     return boost::none;
 }
@@ -402,28 +1147,276 @@ const std::string ConfigNode::nodeName() const
 
 std::vector<ConfigNode> ConfigNode::getChildrenOf(const std::string& rawParentPath) const
 {
-    impl_->getConfigNode();//...just to check locked state
+    const ConfigImage& image(impl_->getImage());
     
     const std::string parentPath(boost::trim_copy(rawParentPath));
 
     const std::string fullParentPath(addPath(path_, parentPath));
 
-    const Tree& parentNode = static_cast<const Tree*>(treeNode_)->get_child(parentPath);
+    const ConfigImage::Node* parentNode = view().findNode(parentPath);
+    if(!parentNode)
+        throw PT::ptree_bad_path("No such node", Path(parentPath));
     std::vector<ConfigNode> result;
-    BOOST_FOREACH(
-        const Tree::value_type& node,
-        parentNode)
+    result.reserve(parentNode->childCount);
+    for(const ConfigImage::Node* node = image.childrenBegin(*parentNode); image.childrenEnd(*parentNode) != node; ++node)
     {
-        const std::string newPath(addPath(fullParentPath, node.first));
+        const std::string newPath(addPath(fullParentPath, image.name(*node)));
         result.push_back(
             ConfigNode(
                 newPath,
                 impl_,
-                &node.second));
+                node));
     }
     return result;
 }
 
+ConfigNodeView::ConfigNodeView(
+    ConfigNode::Impl& impl,
+    const ConfigImageNode& node,
+    boost::uint64_t pathHash):
+    impl_(&impl),
+    node_(&node),
+    pathHash_(pathHash)
+{
+}
+
+std::string ConfigNodeView::name() const
+{
+    return composeName(impl_->appName(), impl_->instanceName(), path());
+}
+
+std::string ConfigNodeView::path() const
+{
+    return impl_->getIndex().path(*node_);
+}
+
+std::string ConfigNodeView::nodeName() const
+{
+    return cutoffLastNode(path()).second;
+}
+
+ConfigNode ConfigNodeView::node() const
+{
+    return ConfigNode(path(), impl_->shared_from_this(), node_);
+}
+
+ConfigNodeView ConfigNodeView::child(const ConfigImageNode& node, const std::string& path) const
+{
+    return ConfigNodeView(*impl_, node, ConfigNode::Impl::pathHash(pathHash_, path.data(), path.size()));
+}
+
+ConfigNodeView ConfigNodeView::getNode(const std::string& path) const
+{
+    boost::optional<ConfigNodeView> optChild(getNodeOptional(path));
+    if(optChild)
+        return *optChild;
+    throw ConfigError(str(
+        boost::format("Config '%1%' doesn't have child '%2%'") %
+        name() %
+        path));
+}
+
+ConfigNodeView ConfigNodeView::getNode(const ConfigPath& path) const
+{
+    boost::optional<ConfigNodeView> optChild(getNodeOptional(path));
+    if(optChild)
+        return *optChild;
+    throw ConfigError(str(
+        boost::format("Config '%1%' doesn't have child '%2%'") %
+        name() %
+        path.str()));
+}
+
+boost::optional<ConfigNodeView> ConfigNodeView::getNodeOptional(const std::string& rawPath) const
+{
+    const std::string path(boost::trim_copy(rawPath));
+    const ConfigImage::Node* node = findNode(path);
+    if(node)
+        return child(*node, path);
+    return boost::none;
+}
+
+boost::optional<ConfigNodeView> ConfigNodeView::getNodeOptional(const ConfigPath& path) const
+{
+    const ConfigImage::Node* node = findNode(path);
+    if(node)
+        return child(*node, path.str());
+    return boost::none;
+}
+
+std::vector<ConfigNodeView> ConfigNodeView::getChildrenOf(const std::string& path) const
+{
+    const ConfigChildren range(children(ConfigPath(path)));
+    return std::vector<ConfigNodeView>(range.begin(), range.end());
+}
+
+ConfigChildren ConfigNodeView::children() const
+{
+    return ConfigChildren(*impl_, *node_, pathHash_);
+}
+
+ConfigChildren ConfigNodeView::children(const ConfigPath& path) const
+{
+    const ConfigImage::Node* parentNode = findNode(path);
+    if(!parentNode)
+        throw PT::ptree_bad_path("No such node", Path(path.str()));
+    return ConfigChildren(*impl_, *parentNode, ConfigNode::Impl::pathHash(pathHash_, path.path_.data(), path.path_.size()));
+}
+
+boost::string_ref ConfigNodeView::rawName() const
+{
+    return boost::string_ref(impl_->getImage().nameBegin(*node_), node_->nameSize);
+}
+
+boost::string_ref ConfigNodeView::rawValue() const
+{
+    return boost::string_ref(impl_->getImage().dataBegin(*node_), node_->dataSize);
+}
+
+boost::uint64_t ConfigNodeView::contentHash() const
+{
+    return impl_->contentHash(*node_);
+}
+
+ConfigChildren::ConfigChildren(ConfigNode::Impl& impl, const ConfigImageNode& parent, boost::uint64_t parentHash):
+    impl_(&impl),
+    parent_(&parent),
+    parentHash_(parentHash),
+    size_(parent.childCount)
+{
+}
+
+ConfigNodeView ConfigChildren::at(size_t index) const
+{
+    return child(*impl_, *parent_, parentHash_, index);
+}
+
+ConfigNodeView ConfigChildren::child(
+    ConfigNode::Impl& impl,
+    const ConfigImageNode& parent,
+    boost::uint64_t parentHash,
+    size_t index)
+{
+    const ConfigImage& image(impl.getImage());
+    const ConfigImage::Node& node(image.childrenBegin(parent)[index]);
+    return ConfigNodeView(
+        impl,
+        node,
+        ConfigNode::Impl::pathHash(parentHash, image.nameBegin(node), node.nameSize));
+}
+
+std::string ConfigNodeView::get(const std::string& rawAttrName) const
+{
+    const std::string attrName(boost::trim_copy(rawAttrName));
+    const ConfigImage::Node* attrNode = findNode(attrName);
+    if(!attrNode)
+        throw ConfigError(str(
+            boost::format("Can't find property '%1%' in config '%2%'") %
+            attrName %
+            name()));
+    if(!attrNode->childCount)
+        return impl_->getImage().data(*attrNode);
+    throw ConfigError(str(
+        boost::format("Node '%1%' is intermidiate node without value") %
+        addPath(name(), attrName)));
+}
+
+boost::optional<std::string> ConfigNodeView::getOptional(const std::string& attrName) const
+{
+    const ConfigImage::Node* attrNode = findValue(attrName);
+    if(!attrNode)
+        return boost::none;
+    return impl_->getImage().data(*attrNode);
+}
+
+std::string ConfigNodeView::get(const std::string& attrName, const std::string& defaultValue) const
+{
+    boost::optional<std::string> value(getOptional(attrName));
+    if(value)
+        return *value;
+    return defaultValue;
+}
+
+std::string ConfigNodeView::get(const ConfigPath& attrPath) const
+{
+    const ConfigImage::Node* attrNode = findNode(attrPath);
+    if(!attrNode)
+        throw ConfigError(str(
+            boost::format("Can't find property '%1%' in config '%2%'") %
+            attrPath.str() %
+            name()));
+    if(!attrNode->childCount)
+        return impl_->getImage().data(*attrNode);
+    throw ConfigError(str(
+        boost::format("Node '%1%' is intermidiate node without value") %
+        addPath(name(), attrPath.str())));
+}
+
+boost::optional<std::string> ConfigNodeView::getOptional(const ConfigPath& attrPath) const
+{
+    const ConfigImage::Node* attrNode = findValue(attrPath);
+    if(!attrNode)
+        return boost::none;
+    return impl_->getImage().data(*attrNode);
+}
+
+const ConfigImageNode* ConfigNodeView::findNode(const std::string& path) const
+{
+    return impl_->findPath(*node_, ConfigNode::Impl::pathHash(pathHash_, path.data(), path.size()), path);
+}
+
+const ConfigImageNode* ConfigNodeView::findNode(const ConfigPath& path) const
+{
+    {//...hash of the path is continued from the node path, it's ready for the root
+        const ConfigPathIndex::Hash hash = ConfigPathIndex::emptyPathHash() == pathHash_ ?
+            path.hash_ :
+            ConfigNode::Impl::pathHash(pathHash_, path.path_.data(), path.path_.size());
+        const ConfigImage::Node* found = impl_->findIndexed(*node_, hash, path.path_.data(), path.path_.size());
+        if(found)
+            return found;
+    }
+    const ConfigImage& image(impl_->getImage());
+    const ConfigImage::Node* node = node_;
+    BOOST_FOREACH(const ConfigPath::Key& key, path.keys_)
+    {
+        const ConfigImage::Index symbol = image.findSymbol(path.path_.data() + key.begin, key.size, key.hash);
+        if(ConfigImage::noSymbol == symbol)
+            return 0;
+        node = image.find(*node, symbol);
+        if(!node)
+            return 0;
+    }
+    return node;
+}
+
+const ConfigImageNode* ConfigNodeView::findValue(const std::string& attrName) const
+{
+    const ConfigImage::Node* attrNode = findNode(boost::trim_copy(attrName));
+    return attrNode && !attrNode->childCount ? attrNode : 0;
+}
+
+const ConfigImageNode* ConfigNodeView::findValue(const ConfigPath& attrPath) const
+{
+    const ConfigImage::Node* attrNode = findNode(attrPath);
+    return attrNode && !attrNode->childCount ? attrNode : 0;
+}
+
+void ConfigNodeView::getValue(const ConfigImageNode& node, const char*& value, size_t& size) const
+{
+    value = impl_->getImage().dataBegin(node);
+    size = node.dataSize;
+}
+
+const boost::any* ConfigNodeView::findCachedValue(const ConfigImageNode& node, const std::type_info& type) const
+{
+    return impl_->findCachedValue(node, type);
+}
+
+const boost::any& ConfigNodeView::cacheValue(const ConfigImageNode& node, const boost::any& value) const
+{
+    return impl_->cacheValue(node, value);
+}
+
 std::ostream& operator<<(std::ostream& os, const ConfigNode& config)
 {
     config.print(os);
@@ -436,12 +1429,24 @@ Config& Config::operator<<(const ConfigSource& source)
     return *this;
 }
 
+Config& Config::operator<<(BOOST_RV_REF(ConfigSource) source)
+{
+    merge(boost::move(source));
+    return *this;
+}
+
+Config& Config::operator<<(const ConfigSources& sources)
+{
+    merge(sources);
+    return *this;
+}
+
 void Config::operator<<(ConfigLock)
 {
     lock();
 }
 
-void ConfigNode::throwValueConversionError(const std::string& attrName, const std::string& value) const
+void ConfigNodeView::throwValueConversionError(const std::string& attrName, const std::string& value) const
 {
     throw ConfigError(str(
         boost::format("Can't convert value '%1%' of a property '%2%' in config '%3%'") %
@@ -450,6 +1455,32 @@ void ConfigNode::throwValueConversionError(const std::string& attrName, const st
         name()));
 }
 
+ConfigPath::ConfigPath(const std::string& path):
+    path_(boost::trim_copy(path))
+{
+    parse();
+}
+
+ConfigPath::ConfigPath(const char* path):
+    path_(boost::trim_copy(std::string(path)))
+{
+    parse();
+}
+
+void ConfigPath::parse()
+{//...the same keys as ConfigImage::findPath finds
+    hash_ = ConfigPathIndex::hash(ConfigPathIndex::emptyPathHash(), path_.data(), path_.size());
+    for(std::string::size_type start = 0; start != path_.size();)
+    {
+        std::string::size_type end = path_.find('.', start);
+        if(std::string::npos == end)
+            end = path_.size();
+        const Key key = { start, end - start, ConfigImage::hash(path_.data() + start, end - start) };
+        keys_.push_back(key);
+        start = end == path_.size() ? end : end + 1;
+    }
+}
+
 Config::Config(const std::string& appName, const std::string& instanceName):
     ConfigNode(appName, instanceName)
 {
@@ -9,22 +9,56 @@
 #ifndef JetConfig_Config_hpp
 #define JetConfig_Config_hpp
 
+#include "ConfigConverter.hpp"
 #include "ConfigSource.hpp"
+#include <boost/any.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/iterator/iterator_facade.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <typeinfo>
 #include <vector>
 
 namespace jet
 {
 
+struct ConfigImageNode;
+class ConfigNodeView;
+class ConfigChildren;
+
+//...Path which is parsed once to be used in many lookups: it's trimmed, split into keys and every key is
+//...hashed beforehand, so lookup with it doesn't allocate memory. It doesn't depend on config, so the same
+//...path can be used with any config and from many threads.
+class ConfigPath
+{
+public:
+    explicit ConfigPath(const std::string& path);
+    explicit ConfigPath(const char* path);
+    const std::string& str() const { return path_; }
+private:
+    void parse();
+    friend class ConfigNodeView;
+    struct Key
+    {
+        size_t begin;
+        size_t size;
+        boost::uint32_t hash;
+    };
+    //...
+    std::string path_;
+    boost::uint64_t hash_;//...of the whole path, it's the key of path index of locked config
+    std::vector<Key> keys_;
+};
+
 class ConfigNode
 {
     class Impl;
     ConfigNode(
         const std::string& path,
         const boost::shared_ptr<Impl>& impl,
-        const void* treeNode);
+        const ConfigImageNode* node);
 public:
     ConfigNode(const ConfigNode& copee);
     ConfigNode& operator=(const ConfigNode& copee);
@@ -36,7 +70,9 @@ public:
     const std::string nodeName() const; //...this is the last part of 'path', e.g. for path 'long.path.to.element' nodeName equal to 'element'
     
     ConfigNode getNode(const std::string& path) const;
+    ConfigNode getNode(const ConfigPath& path) const;
     boost::optional<ConfigNode> getNodeOptional(const std::string& path) const;
+    boost::optional<ConfigNode> getNodeOptional(const ConfigPath& path) const;
     std::vector<ConfigNode> getChildrenOf(const std::string& path = std::string()) const;
     
     std::string get(const std::string& attrName = std::string()) const;
@@ -50,22 +86,169 @@ public:
     std::string get(const std::string& attrName, const std::string& defaultValue) const;
     template<typename T>
     T get(const std::string& attrName, const T& defaultValue) const;
+
+    //...the same as above, but path is already parsed
+    std::string get(const ConfigPath& attrPath) const;
+    template<typename T>
+    T get(const ConfigPath& attrPath) const;
+    boost::optional<std::string> getOptional(const ConfigPath& attrPath) const;
+    template<typename T>
+    boost::optional<T> getOptional(const ConfigPath& attrPath) const;
+    template<typename T>
+    T get(const ConfigPath& attrPath, const T& defaultValue) const;
+
+    ConfigNodeView view() const;//...borrowed handle of the same node of locked config
 protected:
     ConfigNode(const std::string& appName, const std::string& instanceName);
     void merge(const ConfigSource& source);
+    void merge(BOOST_RV_REF(ConfigSource) source);
+    void merge(const ConfigSources& sources);
     void lock();
+    void saveSnapshot(const std::string& filename) const;
+    void loadSnapshot(const std::string& filename);
+    std::vector<std::pair<std::string, std::string> > getProperties() const;
     void print(std::ostream& os) const;
 private:
-    void throwValueConversionError(const std::string& attrName, const std::string& value) const;
+    friend class ConfigNodeView;
+    friend class ConfigChildren;
     friend std::ostream& operator<<(std::ostream& os, const ConfigNode& config);
     //...
     std::string path_;
     boost::shared_ptr<Impl> impl_;
-    const void* treeNode_;
+    const ConfigImageNode* node_;//...node of locked config image, zero means the root
 };
 
 typedef std::vector<ConfigNode> ConfigNodes;
 
+//...Borrowed handle of a node of locked config: pointers to the node and to its config, and hash of the node
+//...path to continue it for lookups in the path index. It's copied without allocation and reference counting,
+//...but it must not outlive its config, while ConfigNode which it's taken from can be gone. Path and name
+//...are composed from the path index only when they are asked for or when an error is reported. Otherwise it's the same as ConfigNode, and ConfigNode reads values through it.
+class ConfigNodeView
+{
+public:
+    std::string name() const;
+    std::string path() const;
+    std::string nodeName() const;
+    ConfigNode node() const;//...owning handle of the same node
+    //...name and value of the node in the image, they are not copied
+    boost::string_ref rawName() const;
+    boost::string_ref rawValue() const;
+    //...hash of the value and the whole subtree of the node, equal subtrees of any configs have equal hashes,
+    //...so changes of a subtree between two configs are found without comparing all its values
+    boost::uint64_t contentHash() const;
+
+    ConfigNodeView getNode(const std::string& path) const;
+    ConfigNodeView getNode(const ConfigPath& path) const;
+    boost::optional<ConfigNodeView> getNodeOptional(const std::string& path) const;
+    boost::optional<ConfigNodeView> getNodeOptional(const ConfigPath& path) const;
+    std::vector<ConfigNodeView> getChildrenOf(const std::string& path = std::string()) const;
+    ConfigChildren children() const;
+    ConfigChildren children(const ConfigPath& path) const;
+
+    std::string get(const std::string& attrName = std::string()) const;
+    template<typename T>
+    T get(const std::string& attrName = std::string()) const;
+    boost::optional<std::string> getOptional(const std::string& attrName = std::string()) const;
+    template<typename T>
+    boost::optional<T> getOptional(const std::string& attrName = std::string()) const;
+    std::string get(const std::string& attrName, const std::string& defaultValue) const;
+    template<typename T>
+    T get(const std::string& attrName, const T& defaultValue) const;
+
+    std::string get(const ConfigPath& attrPath) const;
+    template<typename T>
+    T get(const ConfigPath& attrPath) const;
+    boost::optional<std::string> getOptional(const ConfigPath& attrPath) const;
+    template<typename T>
+    boost::optional<T> getOptional(const ConfigPath& attrPath) const;
+    template<typename T>
+    T get(const ConfigPath& attrPath, const T& defaultValue) const;
+private:
+    friend class ConfigNode;
+    friend class ConfigChildren;
+    ConfigNodeView(
+        ConfigNode::Impl& impl,
+        const ConfigImageNode& node,
+        boost::uint64_t pathHash);
+    ConfigNodeView child(const ConfigImageNode& node, const std::string& path) const;
+    const ConfigImageNode* findNode(const std::string& path) const;
+    const ConfigImageNode* findNode(const ConfigPath& path) const;
+    //...node of the property, zero if it's not found or it's intermediate node
+    const ConfigImageNode* findValue(const std::string& attrName) const;
+    const ConfigImageNode* findValue(const ConfigPath& attrPath) const;
+    //...value of the property is not copied, it stays valid while the config exists
+    void getValue(const ConfigImageNode& node, const char*& value, size_t& size) const;
+    //...value of locked config is converted to every type once, then converted value is copied
+    template<typename T>
+    T convert(const std::string& attrName, const ConfigImageNode& node) const;
+    const boost::any* findCachedValue(const ConfigImageNode& node, const std::type_info& type) const;
+    const boost::any& cacheValue(const ConfigImageNode& node, const boost::any& value) const;
+    void throwValueConversionError(const std::string& attrName, const std::string& value) const;
+    //...
+    ConfigNode::Impl* impl_;
+    const ConfigImageNode* node_;
+    boost::uint64_t pathHash_;
+};
+
+//...Lazy range of children of a node of locked config. Children are yielded as views in their order, one by
+//...one, so iteration doesn't allocate memory. It's used with range-for or BOOST_FOREACH and it must not
+//...outlive its config, like views.
+class ConfigChildren
+{
+public:
+    class iterator: public boost::iterator_facade<
+        iterator,
+        const ConfigNodeView,
+        boost::random_access_traversal_tag,
+        ConfigNodeView>
+    {
+    public:
+        iterator(): impl_(0), parent_(0), parentHash_(0), index_(0) {}
+    private:
+        friend class boost::iterator_core_access;
+        friend class ConfigChildren;
+        //...it refers to the parent node, not to the range, so it stays valid after the range is gone
+        iterator(const ConfigChildren& children, size_t index):
+            impl_(children.impl_),
+            parent_(children.parent_),
+            parentHash_(children.parentHash_),
+            index_(index)
+        {}
+        ConfigNodeView dereference() const { return ConfigChildren::child(*impl_, *parent_, parentHash_, index_); }
+        bool equal(const iterator& other) const { return parent_ == other.parent_ && index_ == other.index_; }
+        void increment() { ++index_; }
+        void decrement() { --index_; }
+        void advance(std::ptrdiff_t offset) { index_ += offset; }
+        std::ptrdiff_t distance_to(const iterator& other) const { return other.index_ - index_; }
+        //...
+        ConfigNode::Impl* impl_;
+        const ConfigImageNode* parent_;
+        boost::uint64_t parentHash_;
+        size_t index_;
+    };
+    typedef iterator const_iterator;
+    ConfigChildren(): impl_(0), parent_(0), parentHash_(0), size_(0) {}//...empty range
+    iterator begin() const { return iterator(*this, 0); }
+    iterator end() const { return iterator(*this, size_); }
+    size_t size() const { return size_; }
+    bool empty() const { return !size_; }
+    ConfigNodeView at(size_t index) const;
+private:
+    friend class ConfigNodeView;
+    ConfigChildren(ConfigNode::Impl& impl, const ConfigImageNode& parent, boost::uint64_t parentHash);
+    static ConfigNodeView child(
+        ConfigNode::Impl& impl,
+        const ConfigImageNode& parent,
+        boost::uint64_t parentHash,
+        size_t index);
+    //...
+    ConfigNode::Impl* impl_;
+    const ConfigImageNode* parent_;
+    boost::uint64_t parentHash_;
+    size_t size_;
+};
+
 extern std::ostream& operator<<(std::ostream& os, const ConfigNode& config);
 
 struct ConfigLock {};
@@ -79,56 +262,133 @@ public:
         const std::string& instanceName = std::string());
 
     Config& operator<<(const ConfigSource& source);
+    //...config << boost::move(source) moves subtrees of the source instead of copying them, if no other handle
+    //...shares the same source. Then the source is left empty, otherwise it is merged as usual
+    Config& operator<<(BOOST_RV_REF(ConfigSource) source);
+    //...the same result as merging of sources one by one in their order, but it's done in one pass over
+    //...all of them, and config is left unchanged if any of sources can't be merged
+    Config& operator<<(const ConfigSources& sources);
     void operator<<(ConfigLock);
+    //...snapshot is a binary image of locked config. It's loaded without parsing and merging of sources,
+    //...so it can be used for fast start or as the last known good config. Loaded config is locked.
+    using ConfigNode::saveSnapshot;
+    using ConfigNode::loadSnapshot;
+    //...full paths and values of all properties of locked config, in no particular order. Properties which
+    //...can't be found by path, that is duplicates and those with empty names or '.' in names, aren't here
+    using ConfigNode::getProperties;
 };
 
 template<typename T>
 inline T ConfigNode::get(const std::string& attrName) const
 {
-    const std::string value(get(attrName));
-    try
-    {
-        return boost::lexical_cast<T>(value);
-    }
-    catch(const boost::bad_lexical_cast&)
-    {
-        throwValueConversionError(attrName, value);
-        throw;
-    }
+    return view().get<T>(attrName);
 }
 
 template<typename T>
 inline boost::optional<T> ConfigNode::getOptional(const std::string& attrName) const
 {
-    const boost::optional<std::string> value(getOptional(attrName));
-    if(!value)
-        return boost::none;
-    try
-    {
-        return boost::lexical_cast<T>(*value);
-    }
-    catch(const boost::bad_lexical_cast&)
-    {
-        throwValueConversionError(attrName, *value);
-        throw;
-    }
+    return view().getOptional<T>(attrName);
 }
 
 template<typename T>
 inline T ConfigNode::get(const std::string& attrName, const T& defaultValue) const
 {
-    boost::optional<std::string> value(getOptional(attrName));
-    if(!value)
+    return view().get<T>(attrName, defaultValue);
+}
+
+template<typename T>
+inline T ConfigNode::get(const ConfigPath& attrPath) const
+{
+    return view().get<T>(attrPath);
+}
+
+template<typename T>
+inline boost::optional<T> ConfigNode::getOptional(const ConfigPath& attrPath) const
+{
+    return view().getOptional<T>(attrPath);
+}
+
+template<typename T>
+inline T ConfigNode::get(const ConfigPath& attrPath, const T& defaultValue) const
+{
+    return view().get<T>(attrPath, defaultValue);
+}
+
+template<typename T>
+inline T ConfigNodeView::get(const std::string& attrName) const
+{
+    const ConfigImageNode* node = findValue(attrName);
+    if(!node)
+        get(attrName);//...it throws the same error as for missing property
+    return convert<T>(attrName, *node);
+}
+
+template<typename T>
+inline boost::optional<T> ConfigNodeView::getOptional(const std::string& attrName) const
+{
+    const ConfigImageNode* node = findValue(attrName);
+    if(!node)
+        return boost::none;
+    return convert<T>(attrName, *node);
+}
+
+template<typename T>
+inline T ConfigNodeView::get(const std::string& attrName, const T& defaultValue) const
+{
+    const ConfigImageNode* node = findValue(attrName);
+    if(!node)
         return defaultValue;
-    try
-    {
-        return boost::lexical_cast<T>(*value);
-    }
-    catch(const boost::bad_lexical_cast&)
-    {
-        throwValueConversionError(attrName, *value);
-        throw;
-    }
+    return convert<T>(attrName, *node);
+}
+
+template<typename T>
+inline T ConfigNodeView::convert(const std::string& attrName, const ConfigImageNode& node) const
+{
+    if(const boost::any* cached = findCachedValue(node, typeid(T)))
+        return *boost::any_cast<T>(cached);
+    const char* value = 0;
+    size_t size = 0;
+    getValue(node, value, size);
+    T converted = T();
+    if(!ConfigConverter<T>::convert(value, size, converted))
+        throwValueConversionError(attrName, std::string(value, size));
+    return *boost::any_cast<T>(&cacheValue(node, boost::any(converted)));
+}
+
+template<>
+inline std::string ConfigNodeView::convert<std::string>(const std::string&, const ConfigImageNode& node) const
+{//...copy of the string is all the conversion, there is nothing to cache
+    const char* value = 0;
+    size_t size = 0;
+    getValue(node, value, size);
+    return std::string(value, size);
+}
+
+template<typename T>
+inline T ConfigNodeView::get(const ConfigPath& attrPath) const
+{
+    const ConfigImageNode* node = findValue(attrPath);
+    if(!node)
+        get(attrPath);//...it throws the same error as for missing property
+    return convert<T>(attrPath.str(), *node);
+}
+
+template<typename T>
+inline boost::optional<T> ConfigNodeView::getOptional(const ConfigPath& attrPath) const
+{
+    const ConfigImageNode* node = findValue(attrPath);
+    if(!node)
+        return boost::none;
+    return convert<T>(attrPath.str(), *node);
+}
+
+template<typename T>
+inline T ConfigNodeView::get(const ConfigPath& attrPath, const T& defaultValue) const
+{
+    const ConfigImageNode* node = findValue(attrPath);
+    if(!node)
+        return defaultValue;
+    return convert<T>(attrPath.str(), *node);
 }
 
 }//namespace jet
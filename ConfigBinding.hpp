@@ -0,0 +1,106 @@
+//
+//  ConfigBinding.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_ConfigBinding_hpp
+#define JetConfig_ConfigBinding_hpp
+
+#include "Config.hpp"
+#include "ConfigError.hpp"
+#include <boost/foreach.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+namespace jet
+{
+
+//...Fields of a struct bound to properties of config. Binding is declared once, usually as a static object,
+//...types of fields are taken from member pointers at compile time and paths are parsed beforehand:
+//...    static const ConfigBinding<Settings> binding = ConfigBinding<Settings>()
+//...        .field(&Settings::port, "server.port")
+//...        .field(&Settings::timeout, "server.timeout", boost::chrono::milliseconds(100));
+//...    const Settings settings(binding.bind(config));
+//...The list of fields is built at run time, so every binding of a struct has the same type which can be
+//...written without C++11 'auto'. It costs a virtual call per field, which is small next to the path lookup.
+//...Every field is read in one pass over fields. If some of them are missing or can't be converted, none is
+//...assigned and ConfigError reports all of them at once.
+template<typename Struct>
+class ConfigBinding
+{
+public:
+    template<typename T>
+    ConfigBinding& field(T Struct::* member, const std::string& path)
+    {
+        fields_.push_back(boost::shared_ptr<Field>(new MemberField<T>(member, path, boost::none)));
+        return *this;
+    }
+    template<typename T>
+    ConfigBinding& field(T Struct::* member, const std::string& path, const T& defaultValue)
+    {
+        fields_.push_back(boost::shared_ptr<Field>(new MemberField<T>(member, path, defaultValue)));
+        return *this;
+    }
+    void bind(const ConfigNode& node, Struct& result) const
+    {
+        const ConfigNodeView view(node.view());//...it throws once if config isn't locked
+        Struct bound(result);
+        std::string errors;
+        BOOST_FOREACH(const boost::shared_ptr<Field>& field, fields_)
+        {
+            try
+            {
+                field->bind(view, bound);
+            }
+            catch(const ConfigError& error)
+            {
+                errors += "\n    ";
+                errors += error.what();
+            }
+        }
+        if(!errors.empty())
+            throw ConfigError("Can't bind config '" + node.name() + "':" + errors);
+        result = bound;
+    }
+    Struct bind(const ConfigNode& node) const
+    {
+        Struct result = Struct();
+        bind(node, result);
+        return result;
+    }
+private:
+    class Field
+    {
+    public:
+        virtual ~Field() {}
+        virtual void bind(const ConfigNodeView& node, Struct& result) const = 0;
+    };
+    template<typename T>
+    class MemberField: public Field
+    {
+    public:
+        MemberField(T Struct::* member, const std::string& path, const boost::optional<T>& defaultValue):
+            member_(member),
+            path_(path),
+            defaultValue_(defaultValue)
+        {}
+        void bind(const ConfigNodeView& node, Struct& result) const
+        {
+            result.*member_ = defaultValue_ ? node.get<T>(path_, *defaultValue_) : node.get<T>(path_);
+        }
+    private:
+        T Struct::* const member_;
+        const ConfigPath path_;
+        const boost::optional<T> defaultValue_;
+    };
+    //...
+    std::vector<boost::shared_ptr<Field> > fields_;
+};
+
+}//namespace jet
+
+#endif /*JetConfig_ConfigBinding_hpp*/
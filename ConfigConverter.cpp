@@ -0,0 +1,244 @@
+//
+//  ConfigConverter.cpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#include "ConfigConverter.hpp"
+#include <boost/spirit/include/qi_numeric.hpp>
+#include <boost/spirit/include/qi_parse.hpp>
+#include <cctype>
+#include <cerrno>
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
+
+namespace jet
+{
+
+namespace
+{
+
+namespace QI = boost::spirit::qi;
+
+template<typename T, typename Parser>
+inline bool parseNumber(const char* value, size_t size, const Parser& parser, T& result)
+{//...qi parsers don't depend on locale and don't allocate memory
+    const char* begin = value;
+    const char* const end = value + size;
+    return QI::parse(begin, end, parser, result) && end == begin;
+}
+
+template<typename T>
+inline bool parseSigned(const char* value, size_t size, T& result)
+{
+    return parseNumber(value, size, QI::int_parser<T, 10, 1, -1>(), result);
+}
+
+template<typename T>
+inline bool parseUnsigned(const char* value, size_t size, T& result)
+{
+    return parseNumber(value, size, QI::uint_parser<T, 10, 1, -1>(), result);
+}
+
+//...Floating point numbers are parsed by strtod of "C" locale, since qi parsers don't round them correctly.
+//...Value isn't terminated by zero in the image, so it's copied, on stack for usual short numbers
+#if defined(_WIN32)
+typedef _locale_t Locale;
+inline Locale cLocale()
+{
+    static const Locale locale = _create_locale(LC_ALL, "C");
+    return locale;
+}
+inline float toReal(const char* value, char** end, float*) { return _strtof_l(value, end, cLocale()); }
+inline double toReal(const char* value, char** end, double*) { return _strtod_l(value, end, cLocale()); }
+inline long double toReal(const char* value, char** end, long double*) { return _strtold_l(value, end, cLocale()); }
+#else
+typedef locale_t Locale;
+inline Locale cLocale()
+{
+    static const Locale locale = newlocale(LC_ALL_MASK, "C", 0);
+    return locale;
+}
+inline float toReal(const char* value, char** end, float*) { return strtof_l(value, end, cLocale()); }
+inline double toReal(const char* value, char** end, double*) { return strtod_l(value, end, cLocale()); }
+inline long double toReal(const char* value, char** end, long double*) { return strtold_l(value, end, cLocale()); }
+#endif
+
+template<typename T>
+inline bool parseReal(const char* value, size_t size, T& result)
+{
+    if(!size || std::isspace(static_cast<unsigned char>(*value)))
+        return false;
+    for(size_t i = 0; i != size; ++i)
+    {//...strtod also takes hexadecimal numbers, they aren't allowed like in other parsers
+        if('x' == value[i] || 'X' == value[i] || '\0' == value[i])
+            return false;
+    }
+    char buffer[64];
+    std::string copy;
+    const char* terminated = buffer;
+    if(size < sizeof(buffer))
+    {
+        std::memcpy(buffer, value, size);
+        buffer[size] = '\0';
+    }
+    else
+    {
+        copy.assign(value, size);
+        terminated = copy.c_str();
+    }
+    char* end = 0;
+    errno = 0;
+    const T parsed = toReal(terminated, &end, static_cast<T*>(0));
+    if(terminated + size != end)
+        return false;
+    if(ERANGE == errno && std::numeric_limits<T>::infinity() == std::fabs(parsed))
+        return false;//...overflow, but underflow to a denormal number or zero is correctly rounded
+    result = parsed;
+    return true;
+}
+
+struct Unit
+{
+    const char* name;
+    boost::uint64_t multiplier;
+};
+
+const Unit BYTE_UNITS[] =
+{
+    { "B", UINT64_C(1) },
+    { "KB", UINT64_C(1000) },
+    { "MB", UINT64_C(1000) * 1000 },
+    { "GB", UINT64_C(1000) * 1000 * 1000 },
+    { "TB", UINT64_C(1000) * 1000 * 1000 * 1000 },
+    { "KiB", UINT64_C(1) << 10 },
+    { "MiB", UINT64_C(1) << 20 },
+    { "GiB", UINT64_C(1) << 30 },
+    { "TiB", UINT64_C(1) << 40 },
+    { 0, 0 }
+};
+
+const Unit DURATION_UNITS[] =
+{
+    { "ns", UINT64_C(1) },
+    { "us", UINT64_C(1000) },
+    { "ms", UINT64_C(1000) * 1000 },
+    { "s", UINT64_C(1000) * 1000 * 1000 },
+    { "min", UINT64_C(60) * 1000 * 1000 * 1000 },
+    { "h", UINT64_C(60) * 60 * 1000 * 1000 * 1000 },
+    { "d", UINT64_C(24) * 60 * 60 * 1000 * 1000 * 1000 },
+    { 0, 0 }
+};
+
+//...number is followed by optional spaces and unit, multiplier is zero if there is no unit
+bool parseQuantity(
+    const char* value,
+    size_t size,
+    const Unit* units,
+    boost::uint64_t& number,
+    boost::uint64_t& multiplier)
+{
+    const char* current = value;
+    const char* const end = value + size;
+    if(end == current || *current < '0' || *current > '9')
+        return false;
+    number = 0;
+    for(; end != current && *current >= '0' && *current <= '9'; ++current)
+    {
+        const boost::uint64_t digit = *current - '0';
+        if(number > (std::numeric_limits<boost::uint64_t>::max() - digit) / 10)
+            return false;
+        number = number * 10 + digit;
+    }
+    if(end == current)
+    {
+        multiplier = 0;
+        return true;
+    }
+    while(end != current && ' ' == *current)
+        ++current;
+    const size_t unitSize = end - current;
+    for(const Unit* unit = units; unit->name; ++unit)
+    {
+        if(std::strlen(unit->name) == unitSize && !std::memcmp(unit->name, current, unitSize))
+        {
+            multiplier = unit->multiplier;
+            return number <= std::numeric_limits<boost::uint64_t>::max() / multiplier;
+        }
+    }
+    return false;
+}
+
+}//anonymous namespace
+
+#define JET_CONFIG_CONVERTER(Type, parse) \
+bool ConfigConverter<Type>::convert(const char* value, size_t size, Type& result) \
+{ \
+    return parse(value, size, result); \
+}
+
+JET_CONFIG_CONVERTER(short, parseSigned)
+JET_CONFIG_CONVERTER(unsigned short, parseUnsigned)
+JET_CONFIG_CONVERTER(int, parseSigned)
+JET_CONFIG_CONVERTER(unsigned int, parseUnsigned)
+JET_CONFIG_CONVERTER(long, parseSigned)
+JET_CONFIG_CONVERTER(unsigned long, parseUnsigned)
+JET_CONFIG_CONVERTER(boost::long_long_type, parseSigned)
+JET_CONFIG_CONVERTER(boost::ulong_long_type, parseUnsigned)
+JET_CONFIG_CONVERTER(float, parseReal)
+JET_CONFIG_CONVERTER(double, parseReal)
+JET_CONFIG_CONVERTER(long double, parseReal)
+
+#undef JET_CONFIG_CONVERTER
+
+bool ConfigConverter<bool>::convert(const char* value, size_t size, bool& result)
+{
+    if((1 == size && '1' == *value) || (4 == size && !std::memcmp(value, "true", 4)))
+        result = true;
+    else if((1 == size && '0' == *value) || (5 == size && !std::memcmp(value, "false", 5)))
+        result = false;
+    else
+        return false;
+    return true;
+}
+
+bool ConfigConverter<ByteSize>::convert(const char* value, size_t size, ByteSize& result)
+{
+    boost::uint64_t number = 0;
+    boost::uint64_t multiplier = 0;
+    if(!parseQuantity(value, size, BYTE_UNITS, number, multiplier))
+        return false;
+    result = ByteSize(multiplier ? number * multiplier : number);
+    return true;
+}
+
+bool parseDuration(const char* value, size_t size, boost::int64_t& duration, bool& hasUnit)
+{
+    const bool isNegative = size && '-' == *value;
+    if(isNegative)
+    {
+        ++value;
+        --size;
+    }
+    boost::uint64_t number = 0;
+    boost::uint64_t multiplier = 0;
+    if(!parseQuantity(value, size, DURATION_UNITS, number, multiplier))
+        return false;
+    hasUnit = 0 != multiplier;
+    if(hasUnit)
+        number *= multiplier;
+    if(number > static_cast<boost::uint64_t>(std::numeric_limits<boost::int64_t>::max()))
+        return false;
+    duration = isNegative ? -static_cast<boost::int64_t>(number) : static_cast<boost::int64_t>(number);
+    return true;
+}
+
+}//namespace jet
@@ -0,0 +1,112 @@
+//
+//  ConfigConverter.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_ConfigConverter_hpp
+#define JetConfig_ConfigConverter_hpp
+
+#include <boost/chrono/duration.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast/try_lexical_convert.hpp>
+#include <cstddef>
+#include <ostream>
+
+namespace jet
+{
+
+//...Converts value of a property into T, it returns false if the value can't be converted. Whole value must be
+//...converted, leading and trailing spaces are not allowed. Numbers, bool, durations and byte sizes are parsed in
+//...place without locale, any other type is converted by lexical_cast. Converter of a user type is added as a
+//...specialization of this template, before config with this type is used:
+//...    template<> struct ConfigConverter<MyType> { static bool convert(const char* value, size_t size, MyType& result); };
+template<typename T>
+struct ConfigConverter
+{
+    static bool convert(const char* value, size_t size, T& result)
+    {
+        return boost::conversion::try_lexical_convert(value, size, result);
+    }
+};
+
+#define JET_CONFIG_CONVERTER(Type) \
+template<> \
+struct ConfigConverter<Type> \
+{ \
+    static bool convert(const char* value, size_t size, Type& result); \
+};
+
+//...integers are decimal, only signed types have optional sign
+JET_CONFIG_CONVERTER(short)
+JET_CONFIG_CONVERTER(unsigned short)
+JET_CONFIG_CONVERTER(int)
+JET_CONFIG_CONVERTER(unsigned int)
+JET_CONFIG_CONVERTER(long)
+JET_CONFIG_CONVERTER(unsigned long)
+JET_CONFIG_CONVERTER(boost::long_long_type)
+JET_CONFIG_CONVERTER(boost::ulong_long_type)
+//...floating point numbers always have '.' as decimal point
+JET_CONFIG_CONVERTER(float)
+JET_CONFIG_CONVERTER(double)
+JET_CONFIG_CONVERTER(long double)
+//...bool is 'true', 'false', '1' or '0'
+JET_CONFIG_CONVERTER(bool)
+
+#undef JET_CONFIG_CONVERTER
+
+//...size in bytes, it's converted from a number with optional unit: 'B', decimal 'KB', 'MB', 'GB', 'TB' or
+//...binary 'KiB', 'MiB', 'GiB', 'TiB', e.g. '64MiB' or '512 KB'
+class ByteSize
+{
+public:
+    explicit ByteSize(boost::uint64_t bytes = 0): bytes_(bytes) {}
+    boost::uint64_t bytes() const { return bytes_; }
+    bool operator==(const ByteSize& other) const { return bytes_ == other.bytes_; }
+    bool operator!=(const ByteSize& other) const { return bytes_ != other.bytes_; }
+private:
+    boost::uint64_t bytes_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const ByteSize& size)
+{
+    return os << size.bytes() << 'B';
+}
+
+template<>
+struct ConfigConverter<ByteSize>
+{
+    static bool convert(const char* value, size_t size, ByteSize& result);
+};
+
+//...nanoseconds of duration with unit 'ns', 'us', 'ms', 's', 'min', 'h' or 'd', e.g. '250ms' or '30 s'. Number
+//...without unit is returned as it is and hasUnit is false
+bool parseDuration(const char* value, size_t size, boost::int64_t& duration, bool& hasUnit);
+
+//...number without unit is a count of the duration type, e.g. '5' is 5 seconds for boost::chrono::seconds. Value
+//...which can't be represented by the duration type exactly, like '1500ms' for seconds, isn't converted
+template<typename Rep, typename Period>
+struct ConfigConverter<boost::chrono::duration<Rep, Period> >
+{
+    typedef boost::chrono::duration<Rep, Period> Duration;
+    static bool convert(const char* value, size_t size, Duration& result)
+    {
+        boost::int64_t duration = 0;
+        bool hasUnit = false;
+        if(!parseDuration(value, size, duration, hasUnit))
+            return false;
+        if(!hasUnit)
+        {
+            result = Duration(static_cast<Rep>(duration));
+            return static_cast<boost::int64_t>(result.count()) == duration;
+        }
+        const boost::chrono::nanoseconds nanoseconds(duration);
+        result = boost::chrono::duration_cast<Duration>(nanoseconds);
+        return boost::chrono::duration_cast<boost::chrono::nanoseconds>(result) == nanoseconds;
+    }
+};
+
+}//namespace jet
+
+#endif /*JetConfig_ConfigConverter_hpp*/
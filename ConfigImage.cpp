@@ -0,0 +1,459 @@
+//
+//  ConfigImage.cpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+#include "ConfigImage.hpp"
+#include "ConfigError.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/crc.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace PT = boost::property_tree;
+typedef PT::ptree::value_type ValueType;
+typedef PT::ptree::const_assoc_iterator CAssocIter;
+typedef PT::ptree Tree;
+
+#define SNAPSHOT_MAGIC "JETCONF"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+
+namespace jet
+{
+
+struct ConfigImage::Header
+{
+    char magic[8];
+    Index byteOrder;//...SNAPSHOT_BYTE_ORDER in the byte order of the writer
+    Index version;
+    Index checksum;//...CRC-32 of everything after the header
+    Index nodeCount;
+    Index stringsSize;
+    Index appName;
+    Index appNameSize;
+    Index instanceName;
+    Index instanceNameSize;
+    Index tableSize;//...size of symbol table, it's a power of 2
+};
+
+struct ConfigImage::Symbol
+{
+    Index name;//...noSymbol for empty slot
+    Index nameSize;
+};
+
+namespace
+{
+
+typedef ConfigImage::Index Index;
+
+inline size_t imageSize(Index nodeCount, Index tableSize, Index stringsSize)
+{
+    return
+        sizeof(ConfigImage::Node) * nodeCount +
+        sizeof(Index) * nodeCount +
+        2 * sizeof(Index) * tableSize +
+        stringsSize;
+}
+
+inline Index checksum(const char* begin, size_t size)
+{
+    boost::crc_32_type crc;
+    crc.process_bytes(begin, size);
+    return crc.checksum();
+}
+
+//...the same names and values repeat all over the tree, so every distinct string is stored once
+class StringPool: boost::noncopyable
+{
+public:
+    Index add(const std::string& value)
+    {
+        const std::pair<Offsets::iterator, bool> inserted(offsets_.insert(std::make_pair(value, Index(0))));
+        if(inserted.second)
+        {
+            inserted.first->second = static_cast<Index>(strings_.size());
+            strings_ += value;
+            strings_ += '\0';//...so even empty string has its own offset
+        }
+        return inserted.first->second;
+    }
+    const std::string& strings() const { return strings_; }
+private:
+    typedef boost::unordered_map<std::string, Index> Offsets;
+    //...
+    std::string strings_;
+    Offsets offsets_;
+};
+
+class SymbolOrder
+{
+public:
+    explicit SymbolOrder(const std::vector<ConfigImage::Node>& nodes): nodes_(nodes) {}
+    bool operator()(Index lhs, Index rhs) const { return nodes_[lhs].name < nodes_[rhs].name; }
+private:
+    const std::vector<ConfigImage::Node>& nodes_;
+};
+
+//...false if the whole data isn't written
+bool writeFile(int file, const char* data, size_t size)
+{
+    while(size)
+    {
+        const ssize_t written = ::write(file, data, size);
+        if(written < 0 && EINTR == errno)
+            continue;
+        if(written <= 0)
+            return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+//...renamed file is durable only when its directory is synced. It's not supported by some file systems, so
+//...it's done if it can be done
+void syncDirectory(const std::string& directory)
+{
+    const int file = ::open(directory.c_str(), O_RDONLY);
+    if(file < 0)
+        return;
+    ::fsync(file);
+    ::close(file);
+}
+
+}//anonymous namespace
+
+const ConfigImage::Index ConfigImage::noSymbol;
+
+ConfigImage::ConfigImage(const Tree& tree, const std::string& appName, const std::string& instanceName):
+    header_(0), size_(0), nodes_(0), order_(0), symbols_(0), strings_(0)
+{
+    std::vector<const Tree*> trees(1, &tree);
+    std::vector<Node> nodes(1);
+    std::vector<Index> order(1, 0);//...root doesn't have siblings
+    StringPool strings;
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.version = SNAPSHOT_VERSION;
+    header.appName = strings.add(appName);
+    header.appNameSize = static_cast<Index>(appName.size());
+    header.instanceName = strings.add(instanceName);
+    header.instanceNameSize = static_cast<Index>(instanceName.size());
+    std::vector<std::pair<const Tree*, Index> > children;
+    for(size_t i = 0; i != trees.size(); ++i)
+    {//...breadth first, so children of a node are adjacent
+        const Tree& current(*trees[i]);
+        nodes[i].data = strings.add(current.data());
+        nodes[i].dataSize = static_cast<Index>(current.data().size());
+        nodes[i].firstChild = static_cast<Index>(nodes.size());
+        nodes[i].childCount = static_cast<Index>(current.size());
+        children.clear();
+        BOOST_FOREACH(const ValueType& child, current)
+        {
+            Node node = {};
+            node.name = strings.add(child.first);
+            node.nameSize = static_cast<Index>(child.first.size());
+            children.push_back(std::make_pair(&child.second, static_cast<Index>(nodes.size())));
+            nodes.push_back(node);
+            trees.push_back(&child.second);
+        }
+        std::sort(children.begin(), children.end());
+        const size_t first = order.size();
+        for(CAssocIter iter = current.ordered_begin(); current.not_found() != iter; ++iter)
+        {
+            order.push_back(
+                std::lower_bound(
+                    children.begin(),
+                    children.end(),
+                    std::make_pair(&iter->second, Index(0)))->second);
+        }
+        //...stable, so children with the same name keep their order
+        std::stable_sort(order.begin() + first, order.end(), SymbolOrder(nodes));
+    }
+    if(nodes.size() > Index(-1) / 2 || strings.strings().size() >= Index(-1))
+        throw ConfigError(str(
+            boost::format("Config '%1%' is too big for a snapshot") % appName));
+    std::vector<Index> names;
+    names.reserve(nodes.size());
+    for(size_t i = 1; i != nodes.size(); ++i)
+        names.push_back(nodes[i].name);
+    std::sort(names.begin(), names.end());
+    std::vector<Symbol> symbols(1);//...at least a half of the table is empty
+    while(symbols.size() < 2 * static_cast<size_t>(std::unique(names.begin(), names.end()) - names.begin()))
+        symbols.resize(2 * symbols.size());
+    const Symbol emptySymbol = { noSymbol, 0 };
+    std::fill(symbols.begin(), symbols.end(), emptySymbol);
+    for(size_t i = 1; i != nodes.size(); ++i)
+    {
+        const Node& node(nodes[i]);
+        const char* const name = strings.strings().data() + node.name;
+        size_t slot = hash(name, node.nameSize) & (symbols.size() - 1);
+        for(; noSymbol != symbols[slot].name && node.name != symbols[slot].name; slot = (slot + 1) & (symbols.size() - 1))
+            ;
+        symbols[slot].name = node.name;
+        symbols[slot].nameSize = node.nameSize;
+    }
+    header.nodeCount = static_cast<Index>(nodes.size());
+    header.tableSize = static_cast<Index>(symbols.size());
+    header.stringsSize = static_cast<Index>(strings.strings().size());
+    buffer_.resize(sizeof(Header) + imageSize(header.nodeCount, header.tableSize, header.stringsSize));
+    char* pos = &buffer_[0] + sizeof(Header);
+    std::memcpy(pos, &nodes[0], sizeof(Node) * nodes.size());
+    pos += sizeof(Node) * nodes.size();
+    std::memcpy(pos, &order[0], sizeof(Index) * order.size());
+    pos += sizeof(Index) * order.size();
+    std::memcpy(pos, &symbols[0], sizeof(Symbol) * symbols.size());
+    pos += sizeof(Symbol) * symbols.size();
+    std::copy(strings.strings().begin(), strings.strings().end(), pos);
+    header.checksum = checksum(&buffer_[0] + sizeof(Header), buffer_.size() - sizeof(Header));
+    std::memcpy(&buffer_[0], &header, sizeof(Header));
+    attach(&buffer_[0], buffer_.size());
+}
+
+ConfigImage::ConfigImage(const std::string& snapshotFilename, size_t offset):
+    header_(0), size_(0), nodes_(0), order_(0), symbols_(0), strings_(0)
+{
+    namespace IP = boost::interprocess;
+    try
+    {
+        const IP::file_mapping file(snapshotFilename.c_str(), IP::read_only);
+        IP::mapped_region(file, IP::read_only, offset).swap(region_);
+    }
+    catch(const IP::interprocess_exception&)
+    {
+        throwSnapshotError(snapshotFilename, "cannot open file");
+    }
+    const char* begin = static_cast<const char*>(region_.get_address());
+    const size_t size = region_.get_size();
+    if(size < sizeof(Header))
+        throwSnapshotError(snapshotFilename, "file is truncated");
+    const Header& header(*reinterpret_cast<const Header*>(begin));
+    if(std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)))
+        throwSnapshotError(snapshotFilename, "file is not a config snapshot");
+    if(SNAPSHOT_BYTE_ORDER != header.byteOrder)
+        throwSnapshotError(snapshotFilename, "snapshot is created on a platform with different byte order");
+    if(SNAPSHOT_VERSION != header.version)
+        throwSnapshotError(snapshotFilename, str(
+            boost::format("unsupported snapshot version %1%") % header.version));
+    if( 0 == header.nodeCount ||
+        header.nodeCount > Index(-1) / 2 ||
+        0 == header.tableSize ||
+        (header.tableSize & (header.tableSize - 1)) ||
+        header.tableSize > Index(-1) / 2 ||
+        size != sizeof(Header) + imageSize(header.nodeCount, header.tableSize, header.stringsSize))
+        throwSnapshotError(snapshotFilename, "file is truncated");
+    if(checksum(begin + sizeof(Header), size - sizeof(Header)) != header.checksum)
+        throwSnapshotError(snapshotFilename, "checksum mismatch");
+    attach(begin, size);
+    {//...checksum doesn't protect from a crafted file, so ranges are checked too
+        const Index nodeCount = header.nodeCount;
+        const Index stringsSize = header.stringsSize;
+        bool isValid =
+            header.appName <= stringsSize && header.appNameSize <= stringsSize - header.appName &&
+            header.instanceName <= stringsSize && header.instanceNameSize <= stringsSize - header.instanceName;
+        for(Index i = 0; isValid && i != nodeCount; ++i)
+        {
+            const Node& node(nodes_[i]);
+            isValid =
+                node.name <= stringsSize && node.nameSize <= stringsSize - node.name &&
+                node.data <= stringsSize && node.dataSize <= stringsSize - node.data &&
+                node.firstChild <= nodeCount && node.childCount <= nodeCount - node.firstChild &&
+                (0 == node.childCount || node.firstChild > i);
+            for(Index child = node.firstChild; isValid && child != node.firstChild + node.childCount; ++child)
+                isValid = order_[child] >= node.firstChild && order_[child] < node.firstChild + node.childCount;
+        }
+        for(Index i = 0; isValid && i != header.tableSize; ++i)
+        {
+            const Symbol& symbol(symbols_[i]);
+            isValid = noSymbol == symbol.name || (symbol.name <= stringsSize && symbol.nameSize <= stringsSize - symbol.name);
+        }
+        if(!isValid)
+            throwSnapshotError(snapshotFilename, "snapshot is corrupted");
+    }
+}
+
+void ConfigImage::save(const std::string& snapshotFilename) const
+{//...snapshot is written to a unique temporary file in the same directory, synced to disk and renamed, so
+ //...concurrent writers don't overwrite each other's files, and after a crash there is either the previous
+ //...snapshot or the whole new one
+    namespace FS = boost::filesystem;
+    FS::path tempFilename;
+    try
+    {
+        tempFilename = FS::unique_path(snapshotFilename + ".%%%%-%%%%-%%%%.tmp");
+    }
+    catch(const FS::filesystem_error& ex)
+    {
+        throw ConfigError(str(
+            boost::format("Couldn't save config snapshot '%1%'. Reason: %2%") % snapshotFilename % ex.what()));
+    }
+    const int file = ::open(tempFilename.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if(file < 0)
+        throw ConfigError(str(
+            boost::format("Couldn't save config snapshot '%1%'. Reason: cannot create file") % snapshotFilename));
+    const bool isWritten = writeFile(file, reinterpret_cast<const char*>(header_), size_) && !::fsync(file);
+    if(::close(file) || !isWritten)
+    {
+        std::remove(tempFilename.c_str());
+        throw ConfigError(str(
+            boost::format("Couldn't save config snapshot '%1%'. Reason: write error") % snapshotFilename));
+    }
+    if(std::rename(tempFilename.c_str(), snapshotFilename.c_str()))
+    {
+        std::remove(tempFilename.c_str());
+        throw ConfigError(str(
+            boost::format("Couldn't save config snapshot '%1%'. Reason: cannot rename file") % snapshotFilename));
+    }
+    const FS::path directory(FS::path(snapshotFilename).parent_path());
+    syncDirectory(directory.empty() ? std::string(".") : directory.string());
+}
+
+size_t ConfigImage::nodeCount() const
+{
+    return header_->nodeCount;
+}
+
+std::string ConfigImage::appName() const
+{
+    return std::string(strings_ + header_->appName, header_->appNameSize);
+}
+
+std::string ConfigImage::instanceName() const
+{
+    return std::string(strings_ + header_->instanceName, header_->instanceNameSize);
+}
+
+ConfigImage::Index ConfigImage::hash(const char* name, size_t size)
+{//...FNV-1a
+    Index res = 2166136261u;
+    for(const char* const end = name + size; end != name; ++name)
+        res = (res ^ static_cast<unsigned char>(*name)) * 16777619u;
+    return res;
+}
+
+ConfigImage::Index ConfigImage::findSymbol(const char* name, size_t size, Index nameHash) const
+{//...probes are limited by table size, so even a crafted table without empty slots is safe
+    const Index mask = header_->tableSize - 1;
+    for(Index probe = 0, slot = nameHash & mask; probe != header_->tableSize; ++probe, slot = (slot + 1) & mask)
+    {
+        const Symbol& symbol(symbols_[slot]);
+        if(noSymbol == symbol.name)
+            break;
+        if(size == symbol.nameSize && !std::char_traits<char>::compare(strings_ + symbol.name, name, size))
+            return symbol.name;
+    }
+    return noSymbol;
+}
+
+const ConfigImage::Node* ConfigImage::find(const Node& node, Index symbol) const
+{//...lower bound, so the first one of the children with the same name is found
+    const Index* first = order_ + node.firstChild;
+    for(size_t count = node.childCount; count > 0;)
+    {
+        const size_t half = count / 2;
+        if(nodes_[first[half]].name < symbol)
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+            count = half;
+    }
+    if(order_ + node.firstChild + node.childCount == first || nodes_[*first].name != symbol)
+        return 0;
+    return &nodes_[*first];
+}
+
+const ConfigImage::Node* ConfigImage::find(const Node& node, const char* name, size_t size) const
+{
+    const Index symbol = findSymbol(name, size);
+    if(noSymbol == symbol)
+        return 0;
+    return find(node, symbol);
+}
+
+const ConfigImage::Node* ConfigImage::findPath(const Node& node, const std::string& path) const
+{
+    const Node* current = &node;
+    for(std::string::size_type start = 0; current && start != path.size();)
+    {
+        std::string::size_type end = path.find('.', start);
+        if(std::string::npos == end)
+            end = path.size();
+        current = find(*current, path.data() + start, end - start);
+        start = end == path.size() ? end : end + 1;
+    }
+    return current;
+}
+
+void ConfigImage::write(std::ostream& os) const
+{
+    os.write(reinterpret_cast<const char*>(header_), size_);
+}
+
+void ConfigImage::copyTo(const Node& node, Tree& tree) const
+{
+    tree.data() = data(node);
+    const Index* const order = order_ + node.firstChild;
+    bool hasSameNames = false;
+    for(Index i = 1; !hasSameNames && i < node.childCount; ++i)
+    {
+        const Node& lhs(nodes_[order[i - 1]]);
+        const Node& rhs(nodes_[order[i]]);
+        hasSameNames = lhs.name == rhs.name;
+    }
+    if(!hasSameNames)
+    {
+        for(const Node* child = childrenBegin(node); childrenEnd(node) != child; ++child)
+            copyTo(*child, tree.push_back(ValueType(name(*child), Tree()))->second);
+        return;
+    }
+    //...children with the same name are found in the order they were inserted into ptree, so they are
+    //...inserted in index order, every one of them at its place in sequence of children
+    std::map<Index, Tree::iterator> inserted;
+    for(Index i = 0; i != node.childCount; ++i)
+    {
+        const Index position = order[i] - node.firstChild;
+        const std::map<Index, Tree::iterator>::const_iterator next(inserted.upper_bound(position));
+        const Tree::iterator child = tree.insert(
+            inserted.end() == next ? tree.end() : next->second,
+            ValueType(name(nodes_[order[i]]), Tree()));
+        inserted.insert(std::make_pair(position, child));
+        copyTo(nodes_[order[i]], child->second);
+    }
+}
+
+void ConfigImage::attach(const char* begin, size_t size)
+{
+    header_ = reinterpret_cast<const Header*>(begin);
+    size_ = size;
+    nodes_ = reinterpret_cast<const Node*>(begin + sizeof(Header));
+    order_ = reinterpret_cast<const Index*>(nodes_ + header_->nodeCount);
+    symbols_ = reinterpret_cast<const Symbol*>(order_ + header_->nodeCount);
+    strings_ = reinterpret_cast<const char*>(symbols_ + header_->tableSize);
+}
+
+void ConfigImage::throwSnapshotError(const std::string& snapshotFilename, const std::string& reason) const
+{
+    throw ConfigError(str(
+        boost::format("Couldn't load config snapshot '%1%'. Reason: %2%") %
+        snapshotFilename %
+        reason));
+}
+
+}//namespace jet
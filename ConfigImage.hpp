@@ -0,0 +1,98 @@
+//
+//  ConfigImage.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_ConfigImage_hpp
+#define JetConfig_ConfigImage_hpp
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace jet
+{
+
+//...node of ConfigImage, it is declared out of the class to be used by ConfigNode without this header
+struct ConfigImageNode
+{
+    boost::uint32_t name;
+    boost::uint32_t nameSize;
+    boost::uint32_t data;
+    boost::uint32_t dataSize;
+    boost::uint32_t firstChild;
+    boost::uint32_t childCount;
+};
+
+//...Compact pointer-free image of a locked config tree. It is the same sequence of bytes in memory and
+//...in a snapshot file, so a snapshot is just mapped and used without any parsing. Layout:
+//...    Header
+//...    Node nodes[nodeCount];      children of every node are adjacent, the first node is the root
+//...    Index order[nodeCount];     for every range of children their indexes sorted by symbol, children with
+//...                                the same name are in the same order as in ptree index
+//...    Symbol symbols[tableSize];  hash table of all distinct node names, it's open addressing with linear probing
+//...    char strings[stringsSize];  names and values, they are zero terminated, equal ones are stored once
+//...Names are interned, so offset of a name in strings is its symbol, and lookup of a child compares integers.
+//...The image is native endian and it is valid only for the same version of the format.
+class ConfigImage: boost::noncopyable
+{
+public:
+    typedef boost::uint32_t Index;
+    typedef ConfigImageNode Node;
+    static const Index noSymbol = Index(-1);
+    //...hash of a name in the symbol table, it's the same on all platforms
+    static Index hash(const char* name, size_t size);
+    ConfigImage(
+        const boost::property_tree::ptree& tree,
+        const std::string& appName,
+        const std::string& instanceName);
+    explicit ConfigImage(const std::string& snapshotFilename, size_t offset = 0);//...image starts at offset
+    void save(const std::string& snapshotFilename) const;
+    void write(std::ostream& os) const;
+    std::string appName() const;
+    std::string instanceName() const;
+    size_t size() const { return size_; }//...in bytes, it's the whole memory taken by the tree
+    const Node& root() const { return nodes_[0]; }
+    size_t nodeCount() const;
+    const Node* childrenBegin(const Node& node) const { return nodes_ + node.firstChild; }
+    const Node* childrenEnd(const Node& node) const { return nodes_ + node.firstChild + node.childCount; }
+    std::string name(const Node& node) const { return std::string(strings_ + node.name, node.nameSize); }
+    const char* nameBegin(const Node& node) const { return strings_ + node.name; }//...there are node.nameSize chars
+    std::string data(const Node& node) const { return std::string(strings_ + node.data, node.dataSize); }
+    const char* dataBegin(const Node& node) const { return strings_ + node.data; }//...there are node.dataSize chars
+    Index symbol(const Node& node) const { return node.name; }
+    //...noSymbol if no node has this name
+    Index findSymbol(const char* name, size_t size) const { return findSymbol(name, size, hash(name, size)); }
+    Index findSymbol(const char* name, size_t size, Index nameHash) const;
+    //...the same child as ptree::find returns, that is the first one in index order
+    const Node* find(const Node& node, Index symbol) const;
+    const Node* find(const Node& node, const char* name, size_t size) const;
+    //...the same node as ptree::get_child_optional returns for '.' delimited path
+    const Node* findPath(const Node& node, const std::string& path) const;
+    //...copy is the same as the original tree, including order of children with the same name in ptree index
+    void copyTo(const Node& node, boost::property_tree::ptree& tree) const;
+private:
+    struct Header;
+    struct Symbol;
+    void attach(const char* begin, size_t size);
+    void throwSnapshotError(const std::string& snapshotFilename, const std::string& reason) const;
+    //...
+    std::vector<char> buffer_;//...image which is built in memory
+    boost::interprocess::mapped_region region_;//...or mapped snapshot
+    const Header* header_;
+    size_t size_;
+    const Node* nodes_;
+    const Index* order_;
+    const Symbol* symbols_;
+    const char* strings_;
+};
+
+}//namespace jet
+
+#endif /*JetConfig_ConfigImage_hpp*/
@@ -0,0 +1,213 @@
+//
+//  ConfigPathIndex.cpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+#include "ConfigPathIndex.hpp"
+#include <algorithm>
+#include <cstring>
+
+#define MAX_DISPLACEMENT 0x100000
+
+namespace jet
+{
+
+namespace
+{
+
+typedef ConfigPathIndex::Hash Hash;
+typedef ConfigPathIndex::Index Index;
+typedef std::pair<Hash, Index> Key;//...hash of full path and node
+
+inline Hash mix(Hash value)
+{//...finalizer of splitmix64
+    value = (value ^ (value >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    value = (value ^ (value >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return value ^ (value >> 31);
+}
+
+class BucketOrder
+{//...bigger buckets go first, when there are more free slots
+public:
+    explicit BucketOrder(const std::vector<std::vector<size_t> >& buckets): buckets_(buckets) {}
+    bool operator()(size_t lhs, size_t rhs) const { return buckets_[lhs].size() > buckets_[rhs].size(); }
+private:
+    const std::vector<std::vector<size_t> >& buckets_;
+};
+
+}//anonymous namespace
+
+Hash ConfigPathIndex::emptyPathHash()
+{
+    return UINT64_C(14695981039346656037);
+}
+
+Hash ConfigPathIndex::hash(Hash pathHash, const char* path, size_t size)
+{//...FNV-1a
+    for(const char* const end = path + size; end != path; ++path)
+        pathHash = (pathHash ^ static_cast<unsigned char>(*path)) * UINT64_C(1099511628211);
+    return pathHash;
+}
+
+size_t ConfigPathIndex::slot(Hash pathHash, boost::int32_t displacement, size_t count)
+{
+    return static_cast<size_t>(mix(pathHash ^ (displacement * UINT64_C(0x9e3779b97f4a7c15))) % count);
+}
+
+ConfigPathIndex::ConfigPathIndex(const ConfigImage& image):
+    image_(image),
+    parents_(image.nodeCount(), noNode())
+{
+    for(Index parent = 0; parent != parents_.size(); ++parent)
+    {
+        const ConfigImage::Node& node(*(&image.root() + parent));
+        for(const ConfigImage::Node* child = image.childrenBegin(node); image.childrenEnd(node) != child; ++child)
+            parents_[index(*child)] = parent;
+    }
+    std::vector<Key> keys(1, Key(emptyPathHash(), 0));
+    for(size_t i = 0; i != keys.size(); ++i)
+    {//...breadth first over nodes which are found by path
+        const ConfigImage::Node& node(*(&image.root() + keys[i].second));
+        for(const ConfigImage::Node* child = image.childrenBegin(node); image.childrenEnd(node) != child; ++child)
+        {
+            if(image.find(node, image.symbol(*child)) != child)
+                continue;//...it's hidden by the first child with the same name
+            const char* const name = image.nameBegin(*child);
+            if(!child->nameSize || std::find(name, name + child->nameSize, '.') != name + child->nameSize)
+                continue;//...trailing '.' of a path is ignored, so empty name is ambiguous
+            Hash pathHash = keys[i].first;
+            if(i)
+                pathHash = hash(pathHash, ".", 1);
+            keys.push_back(Key(hash(pathHash, name, child->nameSize), index(*child)));
+        }
+    }
+    slots_.reserve(keys.size());//...nodes are enumerated in this order if hash can't be built
+    for(std::vector<Key>::const_iterator key = keys.begin(); keys.end() != key; ++key)
+        slots_.push_back(key->second);
+    {
+        std::vector<Key> sorted(keys);
+        std::sort(sorted.begin(), sorted.end());
+        for(size_t i = 1; i < sorted.size(); ++i)
+        {
+            if(sorted[i - 1].first == sorted[i].first)
+                return;
+        }
+    }
+    const size_t count = keys.size();
+    std::vector<std::vector<size_t> > buckets(count);
+    for(size_t key = 0; key != count; ++key)
+        buckets[keys[key].first % count].push_back(key);
+    std::vector<size_t> order;
+    order.reserve(count);
+    for(size_t bucket = 0; bucket != count; ++bucket)
+        order.push_back(bucket);
+    std::sort(order.begin(), order.end(), BucketOrder(buckets));
+    std::vector<boost::int32_t> displacements(count, 0);
+    std::vector<Index> slots(count, noNode());
+    std::vector<size_t> taken;
+    size_t freeSlot = 0;
+    for(std::vector<size_t>::const_iterator bucket = order.begin(); order.end() != bucket; ++bucket)
+    {
+        const std::vector<size_t>& bucketKeys(buckets[*bucket]);
+        if(bucketKeys.empty())
+            break;
+        if(1 == bucketKeys.size())
+        {//...the only key of a bucket takes any free slot, there is no need to search
+            while(noNode() != slots[freeSlot])
+                ++freeSlot;
+            slots[freeSlot] = keys[bucketKeys.front()].second;
+            displacements[*bucket] = -1 - static_cast<boost::int32_t>(freeSlot);
+            continue;
+        }
+        boost::int32_t displacement = 0;
+        for(; MAX_DISPLACEMENT != displacement; ++displacement)
+        {
+            taken.clear();
+            for(size_t i = 0; i != bucketKeys.size(); ++i)
+            {
+                const size_t current = slot(keys[bucketKeys[i]].first, displacement, count);
+                if(noNode() != slots[current] || taken.end() != std::find(taken.begin(), taken.end(), current))
+                    break;
+                taken.push_back(current);
+            }
+            if(taken.size() == bucketKeys.size())
+                break;
+        }
+        if(MAX_DISPLACEMENT == displacement)
+            return;//...it's almost impossible, but then nothing is found in the index
+        for(size_t i = 0; i != bucketKeys.size(); ++i)
+            slots[taken[i]] = keys[bucketKeys[i]].second;
+        displacements[*bucket] = displacement;
+    }
+    displacements_.swap(displacements);
+    slots_.swap(slots);
+}
+
+const ConfigImage::Node* ConfigPathIndex::find(Hash pathHash) const
+{
+    if(displacements_.empty())
+        return 0;
+    const boost::int32_t displacement = displacements_[pathHash % displacements_.size()];
+    const size_t found = displacement < 0 ?
+        static_cast<size_t>(-1 - displacement) :
+        slot(pathHash, displacement, slots_.size());
+    return &image_.root() + slots_[found];
+}
+
+bool ConfigPathIndex::isPath(
+    const ConfigImage::Node& base,
+    const ConfigImage::Node& node,
+    const char* path,
+    size_t size) const
+{//...names of the node and its parents are compared with keys of the path from the last one
+    const ConfigImage::Node* current = &node;
+    for(const char* end = path + size; size;)
+    {
+        const char* begin = end;
+        while(path != begin && '.' != begin[-1])
+            --begin;
+        if( current->nameSize != static_cast<size_t>(end - begin) ||
+            std::memcmp(image_.nameBegin(*current), begin, end - begin))
+            return false;
+        const Index parent = parents_[index(*current)];
+        if(noNode() == parent)
+            return false;
+        current = &image_.root() + parent;
+        if(path == begin)
+            break;
+        end = begin - 1;
+    }
+    return &base == current;
+}
+
+std::string ConfigPathIndex::path(const ConfigImage::Node& node) const
+{
+    std::vector<const ConfigImage::Node*> nodes;
+    for(Index current = index(node); 0 != current && noNode() != current; current = parents_[current])
+        nodes.push_back(&image_.root() + current);
+    std::string res;
+    for(std::vector<const ConfigImage::Node*>::reverse_iterator iter = nodes.rbegin(); nodes.rend() != iter; ++iter)
+    {
+        if(nodes.rbegin() != iter)
+            res += '.';
+        res.append(image_.nameBegin(**iter), (*iter)->nameSize);
+    }
+    return res;
+}
+
+const ConfigImage::Node& ConfigPathIndex::node(size_t slot) const
+{
+    return *(&image_.root() + slots_[slot]);
+}
+
+size_t ConfigPathIndex::size() const
+{
+    return
+        sizeof(*this) +
+        sizeof(boost::int32_t) * displacements_.capacity() +
+        sizeof(Index) * slots_.capacity() +
+        sizeof(Index) * parents_.capacity();
+}
+
+}//namespace jet
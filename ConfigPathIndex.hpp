@@ -0,0 +1,55 @@
+//
+//  ConfigPathIndex.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_ConfigPathIndex_hpp
+#define JetConfig_ConfigPathIndex_hpp
+
+#include "ConfigImage.hpp"
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <vector>
+
+namespace jet
+{
+
+//...Minimal perfect hash (hash and displace) of full paths of config image nodes. Only nodes which are
+//...found by their path are in the index, that is the first one of children with the same name at every
+//...level, and nodes with empty names or names with '.' aren't there. Full path hash is FNV-1a, so hash of
+//...a node path is continued with '.' and relative path to get hash of a path of its descendant. Lookup is
+//...one probe, but the found node must be checked with isPath, because a path which isn't in the index is
+//...mapped to some node too. If two paths have the same 64-bit hash nothing is found, but nodes are still
+//...enumerated.
+class ConfigPathIndex: boost::noncopyable
+{
+public:
+    typedef boost::uint64_t Hash;
+    typedef ConfigImage::Index Index;
+    static Hash emptyPathHash();
+    static Hash hash(Hash pathHash, const char* path, size_t size);//...continues hash of a path
+    explicit ConfigPathIndex(const ConfigImage& image);
+    const ConfigImage::Node* find(Hash pathHash) const;
+    //...true if node is found from base by path
+    bool isPath(const ConfigImage::Node& base, const ConfigImage::Node& node, const char* path, size_t size) const;
+    std::string path(const ConfigImage::Node& node) const;//...full path of any node of the image
+    size_t count() const { return slots_.size(); }
+    const ConfigImage::Node& node(size_t slot) const;//...nodes are in no particular order
+    size_t size() const;//...memory taken by the index in bytes
+private:
+    static Index noNode() { return Index(-1); }
+    static size_t slot(Hash pathHash, boost::int32_t displacement, size_t count);
+    Index index(const ConfigImage::Node& node) const { return static_cast<Index>(&node - &image_.root()); }
+    //...
+    const ConfigImage& image_;
+    std::vector<boost::int32_t> displacements_;//...for every bucket, negative one is -1 - slot of the only node
+    std::vector<Index> slots_;
+    std::vector<Index> parents_;//...for every node of the image
+};
+
+}//namespace jet
+
+#endif /*JetConfig_ConfigPathIndex_hpp*/
@@ -0,0 +1,353 @@
+//
+//  ConfigReloader.cpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#include "ConfigReloader.hpp"
+#include <boost/bind/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <deque>
+#include <utility>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace jet
+{
+
+namespace
+{
+
+typedef boost::posix_time::ptime Time;
+
+inline Time now()
+{
+    return boost::posix_time::microsec_clock::universal_time();
+}
+
+inline double seconds(const boost::posix_time::time_duration& duration)
+{
+    return duration.total_microseconds() / 1e6;
+}
+
+}//anonymous namespace
+
+class ConfigReloader::Impl: boost::noncopyable
+{
+public:
+    Impl(
+        const std::string& appName,
+        const std::string& instanceName,
+        const std::vector<std::string>& filenames,
+        ConfigSource::Format format,
+        unsigned debounceMilliseconds):
+        appName_(appName),
+        instanceName_(instanceName),
+        filenames_(filenames),
+        format_(format),
+        debounce_(boost::posix_time::milliseconds(debounceMilliseconds)),
+        snapshots_(build()),
+        isNotifying_(false),
+        inotify_(-1)
+    {
+        statistics_.reloads = 0;
+        statistics_.failures = 0;
+        statistics_.lastRebuildSeconds = 0;
+        statistics_.lastLatencySeconds = 0;
+        statistics_.callbackFailures = 0;
+        wakeup_[0] = wakeup_[1] = -1;
+        startWatcher();
+    }
+    ~Impl()
+    {
+        stopWatcher();
+    }
+    ConfigSnapshots& snapshots()
+    {
+        return snapshots_;
+    }
+    ConfigSubscriptions& subscriptions()
+    {
+        return subscriptions_;
+    }
+    //...changed is time of the first change of files, reload latency is counted from it
+    void reload(const Time& changed)
+    {
+        {
+            const boost::lock_guard<boost::mutex> guard(reloadMutex_);
+            const Time start(now());
+            boost::shared_ptr<const Config> config;
+            try
+            {
+                config = build();
+            }
+            catch(const std::exception& ex)
+            {
+                const boost::lock_guard<boost::mutex> statisticsGuard(statisticsMutex_);
+                ++statistics_.failures;
+                statistics_.lastError = ex.what();
+                throw;
+            }
+            const Time built(now());
+            const Notification notification = { snapshots_.get(), config };
+            snapshots_.publish(config);//...config is locked, so readers never see it half-built
+            {
+                const boost::lock_guard<boost::mutex> statisticsGuard(statisticsMutex_);
+                ++statistics_.reloads;
+                statistics_.lastRebuildSeconds = seconds(built - start);
+                statistics_.lastLatencySeconds = seconds(now() - changed);
+            }
+            const boost::lock_guard<boost::mutex> notificationsGuard(notificationsMutex_);
+            notifications_.push_back(notification);//...under reload lock, so it's in the order of publication
+        }
+        notify();
+    }
+    Statistics statistics() const
+    {
+        const boost::lock_guard<boost::mutex> statisticsGuard(statisticsMutex_);
+        return statistics_;
+    }
+private:
+    struct Notification
+    {
+        boost::shared_ptr<const Config> previous;
+        boost::shared_ptr<const Config> current;
+    };
+    boost::shared_ptr<const Config> build() const
+    {
+        const boost::shared_ptr<Config> config(new Config(appName_, instanceName_));
+        *config << ConfigSource::createFromFiles(filenames_, format_) << jet::lock;
+        return config;
+    }
+    //...Callbacks are called without reload lock, so they can call reload(). Only one thread calls them, the one
+    //...which finds no one calling, and it goes on while there are notifications, so they are in order of reloads
+    void notify()
+    {
+        {
+            const boost::lock_guard<boost::mutex> guard(notificationsMutex_);
+            if(isNotifying_)
+                return;
+            isNotifying_ = true;
+        }
+        for(;;)
+        {
+            Notification notification;
+            {
+                const boost::lock_guard<boost::mutex> guard(notificationsMutex_);
+                if(notifications_.empty())
+                {
+                    isNotifying_ = false;
+                    return;
+                }
+                notification = notifications_.front();
+                notifications_.pop_front();
+            }
+            try
+            {
+                subscriptions_.notify(*notification.previous, *notification.current);
+            }
+            catch(const std::exception& ex)
+            {
+                callbackFailed(ex.what());
+            }
+            catch(...)
+            {
+                callbackFailed("unknown exception");
+            }
+        }
+    }
+    void callbackFailed(const std::string& error)
+    {
+        const boost::lock_guard<boost::mutex> statisticsGuard(statisticsMutex_);
+        ++statistics_.callbackFailures;
+        statistics_.lastCallbackError = error;
+    }
+#if defined(__linux__)
+    void startWatcher()
+    {//...directories are watched, because editors often replace a file by renaming a new one
+        namespace FS = boost::filesystem;
+        inotify_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(inotify_ < 0)
+            return;//...config is only reloaded by reload()
+        BOOST_FOREACH(const std::string& filename, filenames_)
+        {
+            const FS::path path(filename);
+            const std::string directory(path.has_parent_path() ? path.parent_path().string() : std::string("."));
+            const int watch = ::inotify_add_watch(
+                inotify_,
+                directory.c_str(),
+                IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+            if(watch >= 0)
+                watches_.push_back(std::make_pair(watch, path.filename().string()));
+        }
+        if(::pipe(wakeup_))
+        {
+            wakeup_[0] = wakeup_[1] = -1;
+            return;
+        }
+        watcher_ = boost::thread(boost::bind(&Impl::watch, this));
+    }
+    void stopWatcher()
+    {
+        if(watcher_.joinable())
+        {
+            const char stop = 0;
+            while(::write(wakeup_[1], &stop, 1) < 0 && EINTR == errno);
+            watcher_.join();
+        }
+        for(size_t i = 0; i != 2; ++i)
+        {
+            if(wakeup_[i] >= 0)
+                ::close(wakeup_[i]);
+        }
+        if(inotify_ >= 0)
+            ::close(inotify_);
+    }
+    void watch()
+    {//...config is reloaded when files haven't been changed for debounce time
+        bool isChanged = false;
+        Time changed, lastChange;
+        for(;;)
+        {
+            int timeout = -1;
+            if(isChanged)
+                timeout = static_cast<int>(std::max<boost::int64_t>(0, (debounce_ - (now() - lastChange)).total_milliseconds()));
+            pollfd fds[2] = { { inotify_, POLLIN, 0 }, { wakeup_[0], POLLIN, 0 } };
+            const int ready = ::poll(fds, 2, timeout);
+            if(ready < 0 && EINTR != errno)
+                return;
+            if(ready < 0)
+                continue;
+            if(fds[1].revents)
+                return;
+            if(fds[0].revents)
+            {
+                if(readEvents())
+                {
+                    lastChange = now();
+                    if(!isChanged)
+                        changed = lastChange;
+                    isChanged = true;
+                }
+                continue;
+            }
+            if(isChanged && now() - lastChange >= debounce_)
+            {
+                isChanged = false;
+                try
+                {
+                    reload(changed);
+                }
+                catch(const std::exception&)
+                {//...it's in statistics, current config is kept
+                }
+            }
+        }
+    }
+    //...true if any of config files is changed
+    bool readEvents()
+    {
+        union
+        {
+            inotify_event event;
+            char bytes[4096];
+        } buffer;
+        bool isChanged = false;
+        for(;;)
+        {
+            const ssize_t size = ::read(inotify_, buffer.bytes, sizeof(buffer.bytes));
+            if(size <= 0)
+                return isChanged;
+            for(const char* current = buffer.bytes; current < buffer.bytes + size;)
+            {
+                const inotify_event& event(*reinterpret_cast<const inotify_event*>(current));
+                isChanged = isChanged || (event.mask & IN_Q_OVERFLOW) || (event.len && isWatched(event.wd, event.name));
+                current += sizeof(inotify_event) + event.len;
+            }
+        }
+    }
+    bool isWatched(int watch, const char* name) const
+    {
+        for(std::vector<std::pair<int, std::string> >::const_iterator iter = watches_.begin(); watches_.end() != iter; ++iter)
+        {
+            if(iter->first == watch && iter->second == name)
+                return true;
+        }
+        return false;
+    }
+#else
+    void startWatcher()
+    {
+    }
+    void stopWatcher()
+    {
+    }
+#endif
+    //...
+    const std::string appName_, instanceName_;
+    const std::vector<std::string> filenames_;
+    const ConfigSource::Format format_;
+    const boost::posix_time::time_duration debounce_;
+    ConfigSnapshots snapshots_;
+    ConfigSubscriptions subscriptions_;
+    boost::mutex reloadMutex_;
+    boost::mutex notificationsMutex_;
+    std::deque<Notification> notifications_;
+    bool isNotifying_;
+    mutable boost::mutex statisticsMutex_;
+    Statistics statistics_;
+    int inotify_;
+    int wakeup_[2];
+    std::vector<std::pair<int, std::string> > watches_;//...watch of directory and name of a file in it
+    boost::thread watcher_;
+};
+
+ConfigReloader::ConfigReloader(
+    const std::string& appName,
+    const std::string& instanceName,
+    const std::vector<std::string>& filenames,
+    ConfigSource::Format format,
+    unsigned debounceMilliseconds):
+    impl_(new Impl(appName, instanceName, filenames, format, debounceMilliseconds))
+{
+}
+
+ConfigReloader::~ConfigReloader()
+{
+}
+
+boost::shared_ptr<const Config> ConfigReloader::get() const
+{
+    return impl_->snapshots().get();
+}
+
+ConfigSnapshots& ConfigReloader::snapshots()
+{
+    return impl_->snapshots();
+}
+
+ConfigSubscriptions& ConfigReloader::subscriptions()
+{
+    return impl_->subscriptions();
+}
+
+void ConfigReloader::reload()
+{
+    impl_->reload(now());
+}
+
+ConfigReloader::Statistics ConfigReloader::statistics() const
+{
+    return impl_->statistics();
+}
+
+}//namespace jet
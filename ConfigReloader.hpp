@@ -0,0 +1,65 @@
+//
+//  ConfigReloader.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_ConfigReloader_hpp
+#define JetConfig_ConfigReloader_hpp
+
+#include "Config.hpp"
+#include "ConfigSnapshots.hpp"
+#include "ConfigSubscriptions.hpp"
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+namespace jet
+{
+
+//...Holder of config which is rebuilt when its source files are changed. Directories of the files are watched
+//...on a background thread (with inotify on Linux, elsewhere only reload() rebuilds config). Changes are
+//...debounced, so a save storm of an editor is one reload, then sources are loaded, merged and locked into a
+//...new config which is published atomically. Readers get the current config without waiting for a rebuild,
+//...and config they have got stays valid while they hold it. If new config can't be built the current one
+//...is kept and the error is in statistics, so are exceptions of subscription callbacks.
+class ConfigReloader: boost::noncopyable
+{
+public:
+    struct Statistics
+    {
+        unsigned long reloads;
+        unsigned long failures;
+        double lastRebuildSeconds;//...loading, merging and locking of sources
+        double lastLatencySeconds;//...from the first change of files to publication of config
+        std::string lastError;
+        unsigned long callbackFailures;//...notifications which were stopped by exception of a callback
+        std::string lastCallbackError;
+    };
+    //...the first config is built here, it throws if the config can't be built
+    ConfigReloader(
+        const std::string& appName,
+        const std::string& instanceName,
+        const std::vector<std::string>& filenames,
+        ConfigSource::Format format = ConfigSource::xml,
+        unsigned debounceMilliseconds = 100);
+    ~ConfigReloader();
+    boost::shared_ptr<const Config> get() const;
+    //...readers of many threads should take snapshots of config from here, see ConfigSnapshots
+    ConfigSnapshots& snapshots();
+    //...callbacks of changed paths are called after every reload in order of reloads, on the thread which has
+    //...reloaded config, or on the one which is calling them for a previous reload. Callbacks can call reload()
+    ConfigSubscriptions& subscriptions();
+    //...rebuilds config right now, e.g. on SIGHUP. It throws if config can't be built
+    void reload();
+    Statistics statistics() const;
+private:
+    class Impl;
+    boost::shared_ptr<Impl> impl_;
+};
+
+}//namespace jet
+
+#endif /*JetConfig_ConfigReloader_hpp*/
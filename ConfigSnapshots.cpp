@@ -0,0 +1,89 @@
+//
+//  ConfigSnapshots.cpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#include "ConfigSnapshots.hpp"
+#include <boost/foreach.hpp>
+#include <boost/thread/locks.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace jet
+{
+
+ConfigSnapshots::ConfigSnapshots(const boost::shared_ptr<const Config>& config):
+    current_(config.get()),
+    epoch_(1),
+    config_(config)
+{
+}
+
+ConfigSnapshots::~ConfigSnapshots()
+{
+    assert(slots_.empty());
+}
+
+void ConfigSnapshots::publish(const boost::shared_ptr<const Config>& config)
+{
+    const boost::lock_guard<boost::mutex> guard(mutex_);
+    retired_.push_back(std::make_pair(epoch_.load() + 1, config_));
+    boost::atomic_store(&config_, config);
+    current_.store(config.get(), boost::memory_order_seq_cst);
+    epoch_.fetch_add(1, boost::memory_order_seq_cst);//...reader which sees new epoch also sees new config
+    reclaim();
+}
+
+boost::shared_ptr<const Config> ConfigSnapshots::get() const
+{
+    return boost::atomic_load(&config_);
+}
+
+size_t ConfigSnapshots::retired() const
+{
+    const boost::lock_guard<boost::mutex> guard(mutex_);
+    return retired_.size();
+}
+
+void ConfigSnapshots::reclaim()
+{//...config retired with epoch E isn't read if every slot is either not read or has entered at E or later
+    boost::uint64_t oldest = std::numeric_limits<boost::uint64_t>::max();
+    BOOST_FOREACH(const Slot* slot, slots_)
+    {
+        const boost::uint64_t epoch = slot->epoch.load(boost::memory_order_seq_cst);
+        if(epoch)
+            oldest = std::min(oldest, epoch);
+    }
+    size_t kept = 0;
+    for(size_t i = 0; i != retired_.size(); ++i)
+    {
+        if(retired_[i].first > oldest)
+            retired_[kept++] = retired_[i];
+    }
+    retired_.resize(kept);
+}
+
+ConfigSnapshots::Reader::Reader(ConfigSnapshots& snapshots):
+    snapshots_(snapshots),
+    slot_(new Slot()),
+    depth_(0)
+{
+    slot_->epoch.store(0);
+    const boost::lock_guard<boost::mutex> guard(snapshots_.mutex_);
+    snapshots_.slots_.push_back(slot_);
+}
+
+ConfigSnapshots::Reader::~Reader()
+{
+    assert(!depth_);
+    {
+        const boost::lock_guard<boost::mutex> guard(snapshots_.mutex_);
+        snapshots_.slots_.erase(std::find(snapshots_.slots_.begin(), snapshots_.slots_.end(), slot_));
+        snapshots_.reclaim();
+    }
+    delete slot_;
+}
+
+}//namespace jet
@@ -0,0 +1,106 @@
+//
+//  ConfigSnapshots.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_ConfigSnapshots_hpp
+#define JetConfig_ConfigSnapshots_hpp
+
+#include "Config.hpp"
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace jet
+{
+
+//...Current locked config published for many reader threads. A thread reads config through its own Reader:
+//...    jet::ConfigSnapshots::Reader reader(snapshots);//...once per thread
+//...    ...
+//...    const jet::ConfigSnapshots::Snapshot config(reader);//...per request
+//...    const int port = config->get<int>(portPath);
+//...Snapshot doesn't own config and doesn't touch its reference counter, it only marks the slot of the reader
+//...with the current epoch, so readers don't write shared memory. When a new config is published, the previous
+//...one is retired with a new epoch and released once no reader is inside a snapshot taken before that epoch.
+//...Nodes taken from a snapshot must not outlive it, use ConfigNodeView or get() to keep config longer.
+//...Readers must be destroyed before snapshots.
+class ConfigSnapshots: boost::noncopyable
+{
+    struct Slot;
+public:
+    class Reader;
+    class Snapshot;
+
+    explicit ConfigSnapshots(const boost::shared_ptr<const Config>& config);
+    ~ConfigSnapshots();
+    //...config must be locked
+    void publish(const boost::shared_ptr<const Config>& config);
+    //...owning pointer to the current config, it's slower than Snapshot
+    boost::shared_ptr<const Config> get() const;
+    //...count of previous configs which are still read
+    size_t retired() const;
+private:
+    void reclaim();
+    //...
+    boost::atomic<const Config*> current_;
+    boost::atomic<boost::uint64_t> epoch_;//...it starts from 1, zero epoch of a slot means that it's not read
+    boost::shared_ptr<const Config> config_;
+    mutable boost::mutex mutex_;
+    std::vector<Slot*> slots_;
+    std::vector<std::pair<boost::uint64_t, boost::shared_ptr<const Config> > > retired_;
+};
+
+struct ConfigSnapshots::Slot
+{//...padding keeps epoch of every reader on its own cache line
+    char before[64];
+    boost::atomic<boost::uint64_t> epoch;
+    char after[64];
+};
+
+class ConfigSnapshots::Reader: boost::noncopyable
+{
+public:
+    explicit Reader(ConfigSnapshots& snapshots);
+    ~Reader();
+private:
+    friend class Snapshot;
+    const Config* enter()
+    {//...store of epoch is ordered before load of config, publish() orders them in the opposite way
+        if(!depth_++)
+            slot_->epoch.store(snapshots_.epoch_.load(boost::memory_order_acquire), boost::memory_order_seq_cst);
+        return snapshots_.current_.load(boost::memory_order_seq_cst);
+    }
+    void exit()
+    {
+        if(!--depth_)
+            slot_->epoch.store(0, boost::memory_order_release);
+    }
+    //...
+    ConfigSnapshots& snapshots_;
+    Slot* const slot_;
+    unsigned depth_;
+};
+
+//...Snapshots of the same reader can be nested, all of them are valid until the outer one is destroyed
+class ConfigSnapshots::Snapshot: boost::noncopyable
+{
+public:
+    explicit Snapshot(Reader& reader): reader_(reader), config_(reader.enter()) {}
+    ~Snapshot() { reader_.exit(); }
+    const Config& operator*() const { return *config_; }
+    const Config* operator->() const { return config_; }
+private:
+    Reader& reader_;
+    const Config* const config_;
+};
+
+}//namespace jet
+
+#endif /*JetConfig_ConfigSnapshots_hpp*/
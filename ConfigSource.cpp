@@ -7,11 +7,27 @@
 //
 #include "ConfigSourceImpl.hpp"
 #include "ConfigError.hpp"
+#include "ConfigWriter.hpp"
+#include "JsonReader.hpp"
+#include "XmlReader.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/property_tree/exceptions.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
 
 namespace PT = boost::property_tree;
 typedef PT::ptree::value_type ValueType;
@@ -40,293 +56,747 @@ inline std::string pruneString(const std::string& data, size_t maxSize = 10)
     return data;
 }
 
+inline bool isKeyword(const char* name, size_t size, const char* keyword)
+{//...case insensitive comparison with lower case keyword which doesn't allocate lower case copy of name
+    for(size_t i = 0; i != size; ++i, ++keyword)
+    {
+        const char ch = ('A' <= name[i] && name[i] <= 'Z') ? name[i] - 'A' + 'a' : name[i];
+        if(ch != *keyword)
+            return false;
+    }
+    return '\0' == *keyword;
+}
+
+inline bool isKeyword(const std::string& name, const char* keyword)
+{
+    return isKeyword(name.data(), name.size(), keyword);
+}
+
+//...compares name as it will be after normalization, application names are lower cased for CaseInsensitive style
+inline bool isNormalizedName(const char* name, size_t size, const std::string& normalizedName, bool toLower)
+{
+    if(size != normalizedName.size())
+        return false;
+    for(size_t i = 0; i != size; ++i)
+    {
+        const char ch = (toLower && 'A' <= name[i] && name[i] <= 'Z') ? name[i] - 'A' + 'a' : name[i];
+        if(ch != normalizedName[i])
+            return false;
+    }
+    return true;
+}
+
+//...children are sorted by name in ptree index, so duplicates are adjacent there
+inline bool hasDuplicateChildren(const Tree& tree)
+{
+    if(tree.size() < 2)
+        return false;
+    CAssocIter iter(tree.ordered_begin());
+    for(CAssocIter next(iter); tree.not_found() != ++next; iter = next)
+    {
+        if(iter->first == next->first)
+            return true;
+    }
+    return false;
+}
+
+//...Finds the first sibling (in order of their addition) which has a duplicate name. This is the same node
+//...as the first one for which 'count(name) > 1' is true, but it takes linear time instead of quadratic.
+class DuplicateFinder: boost::noncopyable
+{
+public:
+    DuplicateFinder(): duplicate_(0), duplicateIndex_(0), size_(0) {}
+    void add(const std::string& name)
+    {
+        const std::pair<Index::iterator, bool> inserted(index_.insert(std::make_pair(&name, size_)));
+        if(!inserted.second && (!duplicate_ || inserted.first->second < duplicateIndex_))
+        {
+            duplicate_ = inserted.first->first;
+            duplicateIndex_ = inserted.first->second;
+        }
+        ++size_;
+    }
+    const std::string* duplicate() const { return duplicate_; }
+private:
+    struct NameHash
+    {
+        size_t operator()(const std::string* name) const { return boost::hash_range(name->begin(), name->end()); }
+    };
+    struct NameEqual
+    {
+        bool operator()(const std::string* lhs, const std::string* rhs) const { return *lhs == *rhs; }
+    };
+    typedef boost::unordered_map<const std::string*, size_t, NameHash, NameEqual> Index;
+    //...
+    Index index_;
+    const std::string* duplicate_;
+    size_t duplicateIndex_;
+    size_t size_;
+};
+
+//...All rules are checked during one traversal of the tree. Every rule remembers its first violation
+//...(in the same order as a separate pass for the rule would find it) and the error of the rule with
+//...the highest priority is thrown, so errors are the same as if rules were checked one by one.
 class Validator: boost::noncopyable
 {
 public:
     Validator(const std::string& sourceName, const Tree& root):
-        sourceName_(sourceName), root_(root)
+        sourceName_(sourceName), root_(root), shared_(0)
     {
         assert(root_.front().first == ROOT_NODE_NAME);
     }
-    void checkTreeDoesNotHaveDataAndAttributeNodes() const
-    {
-        const Tree::value_type& config(root_.front());
-        
-        checkNodeDoesNotHaveDataAndAttribute(config.first, config.second);
-    }
-    void checkNoDataInConfigNode() const
+    void validate()
     {
         const Tree::value_type& config(root_.front());
         if(!config.second.data().empty())
-            throw ConfigError(str(
+            reportError(NoDataInConfigNode, str(
                 boost::format("Invalid data node '%1%' under '" ROOT_NODE_NAME "' node in config source '%2%'") %
                 pruneString(config.second.data()) %
                 sourceName_));
-    }
-    void checkNoDataInSharedNode() const
-    {
-        const Tree::value_type& config(root_.front());
         const CAssocIter sharedIter = config.second.find(SHARED_NODE_NAME);
-        if(config.second.not_found() == sharedIter)
-            return;
-        if(!sharedIter->second.data().empty())
-            throw ConfigError(str(
-                boost::format("Invalid data node '%1%' under '" SHARED_NODE_NAME "' node in config source '%2%'") %
-                pruneString(sharedIter->second.data()) %
-                sourceName_));
-    }
-    void checkNoDataInAppAndInstanceNode() const
-    {
-        const Tree::value_type& config(root_.front());
-        BOOST_FOREACH(const Tree::value_type& appNode, config.second)
+        if(config.second.not_found() != sharedIter)
         {
-            if(SHARED_NODE_NAME == appNode.first)
-                continue;
-            if(!appNode.second.data().empty())
-                throw ConfigError(str(
-                    boost::format("Invalid data node '%1%' under '%2%' node in config source '%3%'") %
-                    pruneString(appNode.second.data()) %
-                    appNode.first %
+            shared_ = &sharedIter->second;
+            if(!shared_->data().empty())
+                reportError(NoDataInSharedNode, str(
+                    boost::format("Invalid data node '%1%' under '" SHARED_NODE_NAME "' node in config source '%2%'") %
+                    pruneString(shared_->data()) %
                     sourceName_));
-            const CAssocIter instanceIter = appNode.second.find(INSTANCE_NODE_NAME);
-            if(appNode.second.not_found() == instanceIter)
-                continue;
-            BOOST_FOREACH(const Tree::value_type& instanceNode, instanceIter->second)
-            {
-                if(!instanceNode.second.data().empty())
-                {
-                    std::string instanceName(appNode.first);
-                    instanceName += INSTANCE_DELIMITER_CHAR;
-                    instanceName += instanceNode.first;
-                    throw ConfigError(str(
-                        boost::format("Invalid data node '%1%' under '%2%' node in config source '%3%'") %
-                        pruneString(instanceNode.second.data()) %
-                        instanceName %
-                        sourceName_));
-                }
-            }
+        }
+        path_ = config.first;
+        checkDataAndAttributes(config.second);
+        visitConfigNode(config.second);
+        for(size_t rule = 0; rule != RuleCount; ++rule)
+        {
+            if(!errors_[rule].empty())
+                throw ConfigError(errors_[rule]);
         }
     }
-    void checkNoSharedNodeDuplicates() const
+private:
+    enum Rule//...in order of priority
     {
-        const Tree::value_type& config(root_.front());
-        if(config.second.count(SHARED_NODE_NAME) > 1)
-            throw ConfigError(str(
-                boost::format("Duplicate shared node in config source '%1%'") % sourceName_));
-    }
-    void checkNoSharedSubnodeDuplicates() const
+        NoDataInConfigNode,
+        NoDataInSharedNode,
+        NoDataInAppAndInstanceNode,
+        NoDataAndAttributeNodes,
+        NoSharedNodeDuplicates,
+        NoSharedSubnodeDuplicates,
+        NoSharedInstanceNode,
+        NoDirectSharedAttributes,
+        NoAppNodeDuplicates,
+        NoInstanceNodeDuplicates,
+        NoInstanceSubnodeDuplicates,
+        RuleCount
+    };
+    void visitConfigNode(const Tree& config)
     {
-        const Tree::value_type& config(root_.front());
-        const CAssocIter sharedIter = config.second.find(SHARED_NODE_NAME);
-        if(config.second.not_found() == sharedIter)
-            return;
-
-        BOOST_FOREACH(const Tree::value_type& sharedChild, sharedIter->second)
+        DuplicateFinder appNodes;
+        size_t sharedCount = 0;
+        BOOST_FOREACH(const Tree::value_type& node, config)
         {
-            if(sharedIter->second.count(sharedChild.first) > 1)
-                throw ConfigError(str(
-                    boost::format("Duplicate shared node '%1%' in config source '%2%'") %
-                    sharedChild.first %
-                    sourceName_));
+            appNodes.add(node.first);
+            if(SHARED_NODE_NAME == node.first)
+            {
+                ++sharedCount;
+                if(shared_ == &node.second)
+                    visitSharedNode(node.second);
+                else
+                    visitNode(node);
+            }
+            else
+                visitAppNode(node);
         }
+        if(sharedCount > 1)
+            reportError(NoSharedNodeDuplicates, str(
+                boost::format("Duplicate shared node in config source '%1%'") % sourceName_));
+        if(appNodes.duplicate())
+            reportError(NoAppNodeDuplicates, str(
+                boost::format("Duplicate node '%1%' in config source '%2%'") %
+                *appNodes.duplicate() %
+                sourceName_));
     }
-    void checkNoSharedInstanceNode() const
+    void visitSharedNode(const Tree& shared)
     {
-        const Tree::value_type& config(root_.front());
-        const CAssocIter sharedIter = config.second.find(SHARED_NODE_NAME);
-        if(config.second.not_found() == sharedIter)
-            return;
-        BOOST_FOREACH(const Tree::value_type& node, sharedIter->second)
+        const size_t pathSize = pushPath(SHARED_NODE_NAME);
+        checkDataAndAttributes(shared);
+        DuplicateFinder sharedNodes;
+        BOOST_FOREACH(const Tree::value_type& node, shared)
         {
-            const std::string nodeName = boost::to_lower_copy(node.first);
-            if(nodeName == INSTANCE_NODE_NAME)
-                throw ConfigError(str(
+            sharedNodes.add(node.first);
+            if(isKeyword(node.first, INSTANCE_NODE_NAME))
+                reportError(NoSharedInstanceNode, str(
                     boost::format("Config source '%1%' is invalid: '" SHARED_NODE_NAME "' node can not contain '%2%' node") %
                     sourceName_ %
                     node.first));
-        }
-    }
-    void checkNoDirectSharedAttributes() const
-    {
-        const Tree::value_type& config(root_.front());
-        const CAssocIter sharedIter = config.second.find(SHARED_NODE_NAME);
-        if(config.second.not_found() == sharedIter)
-            return;
-        BOOST_FOREACH(const Tree::value_type& node, sharedIter->second)
-        {
             if(!node.second.data().empty())
-                throw ConfigError(str(
+                reportError(NoDirectSharedAttributes, str(
                     boost::format("Config source '%1%' is invalid: '" SHARED_NODE_NAME "' node can not contain direct properties. See '" SHARED_NODE_NAME ".%2%' property") %
                     sourceName_ %
                     node.first));
+            visitNode(node);
         }
+        if(sharedNodes.duplicate())
+            reportError(NoSharedSubnodeDuplicates, str(
+                boost::format("Duplicate shared node '%1%' in config source '%2%'") %
+                *sharedNodes.duplicate() %
+                sourceName_));
+        popPath(pathSize);
     }
-    void checkNoAppNodeDuplicates() const
+    void visitAppNode(const Tree::value_type& app)
     {
-        const Tree::value_type& config(root_.front());
-        BOOST_FOREACH(const Tree::value_type& node, config.second)
+        const std::string& appName(app.first);
+        if(!app.second.data().empty())
+            reportError(NoDataInAppAndInstanceNode, str(
+                boost::format("Invalid data node '%1%' under '%2%' node in config source '%3%'") %
+                pruneString(app.second.data()) %
+                appName %
+                sourceName_));
+        const size_t pathSize = pushPath(appName);
+        checkDataAndAttributes(app.second);
+        const CAssocIter instanceIter = app.second.find(INSTANCE_NODE_NAME);
+        size_t instanceCount = 0;
+        BOOST_FOREACH(const Tree::value_type& node, app.second)
         {
-            if(config.second.count(node.first) > 1)
-                throw ConfigError(str(
-                    boost::format("Duplicate node '%1%' in config source '%2%'") %
-                    node.first %
-                    sourceName_));
+            if(INSTANCE_NODE_NAME == node.first)
+                ++instanceCount;
+            if(app.second.not_found() != instanceIter && &instanceIter->second == &node.second)
+                visitInstancesNode(appName, node.second);
+            else
+                visitNode(node);
         }
+        if(instanceCount > 1)
+            reportError(NoInstanceNodeDuplicates, str(
+                boost::format("Duplicate " INSTANCE_NODE_NAME " node under '%1%' node in config source '%2%'") %
+                appName %
+                sourceName_));
+        popPath(pathSize);
     }
-    void checkNoInstanceNodeDuplicates() const
+    void visitInstancesNode(const std::string& appName, const Tree& instances)
     {
-        const Tree::value_type& config(root_.front());
-        BOOST_FOREACH(const Tree::value_type& node, config.second)
+        const size_t pathSize = pushPath(INSTANCE_NODE_NAME);
+        checkDataAndAttributes(instances);
+        DuplicateFinder instanceNodes;
+        BOOST_FOREACH(const Tree::value_type& node, instances)
         {
-            checkNoInstanceNodeDuplicatesImpl(node.first, node.second);
+            instanceNodes.add(node.first);
+            if(!node.second.data().empty())
+                reportError(NoDataInAppAndInstanceNode, str(
+                    boost::format("Invalid data node '%1%' under '%2%' node in config source '%3%'") %
+                    pruneString(node.second.data()) %
+                    instanceName(appName, node.first) %
+                    sourceName_));
+            visitNode(node);
         }
+        if(instanceNodes.duplicate())
+            reportError(NoInstanceSubnodeDuplicates, str(
+                boost::format("Duplicate node '%1%' in config source '%2%'") %
+                instanceName(appName, *instanceNodes.duplicate()) %
+                sourceName_));
+        popPath(pathSize);
     }
-    void checkNoInstanceSubnodeDuplicates() const
+    void visitNode(const Tree::value_type& node)
     {
-        const Tree::value_type& config(root_.front());
-        BOOST_FOREACH(const Tree::value_type& node, config.second)
-        {
-            checkNoInstanceSubnodeDuplicatesImpl(node.first, node.second);
-        }
+        if(!errors_[NoDataAndAttributeNodes].empty())
+            return;//...this is the only rule checked for the whole depth of the tree
+        const size_t pathSize = pushPath(node.first);
+        checkDataAndAttributes(node.second);
+        BOOST_FOREACH(const Tree::value_type& child, node.second)
+            visitNode(child);
+        popPath(pathSize);
     }
-private:
-    void checkNodeDoesNotHaveDataAndAttribute(const Path& currentPath, const Tree& tree) const
+    void checkDataAndAttributes(const Tree& tree)
     {
         if(!tree.empty() && !tree.data().empty())
-            throw ConfigError(str(
+            reportError(NoDataAndAttributeNodes, str(
                 boost::format("Invalid element '%1%' in config source '%2%' contains both value and child attributes") %
-                currentPath.dump() %
+                path_ %
                 sourceName_));
-        BOOST_FOREACH(const Tree::value_type& node, tree)
+    }
+    //...path is built the same way as 'Path / Path(name)', that is empty name doesn't add a delimiter
+    size_t pushPath(const std::string& name)
+    {
+        const size_t size = path_.size();
+        if(!name.empty())
         {
-            const Path nodePath(currentPath/Path(node.first));
-            checkNodeDoesNotHaveDataAndAttribute(nodePath, node.second);
+            path_ += '.';
+            path_ += name;
         }
+        return size;
     }
-    void checkNoInstanceNodeDuplicatesImpl(const std::string& appName, const Tree& appNode) const
+    void popPath(size_t size) { path_.resize(size); }
+    static std::string instanceName(const std::string& appName, const std::string& instanceName)
     {
-        if(SHARED_NODE_NAME == appName)//...in fact this is not an application node
-            return;
-        if(appNode.count(INSTANCE_NODE_NAME) > 1)
-            throw ConfigError(str(
-                boost::format("Duplicate " INSTANCE_NODE_NAME " node under '%1%' node in config source '%2%'") %
-                appName %
-                sourceName_));
+        std::string res(appName);
+        res += INSTANCE_DELIMITER_CHAR;
+        res += instanceName;
+        return res;
     }
-    void checkNoInstanceSubnodeDuplicatesImpl(const std::string& appName, const Tree& appNode) const
+    void reportError(Rule rule, const std::string& message)
     {
-        if(SHARED_NODE_NAME == appName)//...in fact this is not an application node
-            return;
-        const CAssocIter instanceIter = appNode.find(INSTANCE_NODE_NAME);
-        if(appNode.not_found() == instanceIter)
-            return;
-        BOOST_FOREACH(const Tree::value_type& instanceSubnode, instanceIter->second)
-        {
-            if(instanceIter->second.count(instanceSubnode.first) > 1)
-            {
-                std::string instanceName(appName);
-                instanceName += INSTANCE_DELIMITER_CHAR;
-                instanceName += instanceSubnode.first;
-                throw ConfigError(str(
-                    boost::format("Duplicate node '%1%' in config source '%2%'") %
-                    instanceName %
-                    sourceName_));
-            }
-        }
+        if(errors_[rule].empty())
+            errors_[rule] = message;
     }
+    //...
     const std::string& sourceName_;
     const Tree& root_;
+    const Tree* shared_;
+    std::string path_;
+    std::string errors_[RuleCount];
+};
+
+//...read-only stream over caller's buffer, so read_xml reads it in place without a copy
+class MemoryBuffer: public std::streambuf
+{
+public:
+    MemoryBuffer(const char* begin, const char* end)
+    {
+        char* data = const_cast<char*>(begin);
+        setg(data, data, data + (end - begin));
+    }
 };
 
 }//anonymous namespace
 
+//...Builds exactly the same tree as read_xml followed by normalizeXmlAttributes and normalizeRootNode,
+//...but does it while source is being tokenized, so the whole tree is never walked again. Only shallow
+//...'config' and application levels are normalized after the source is read, because application node
+//...can be defined after its abbreviated 'app:instance' node. Normalization errors are reported after
+//...the whole source is read, so syntax errors take precedence like in read_xml path.
+//...If source has a filter, nodes which aren't selected by it are skipped before anything is built.
+class ConfigSource::Impl::TreeBuilder: boost::noncopyable
+{
+public:
+    TreeBuilder(const Impl& source, ConfigSource::FileNameStyle fileNameStyle, Tree& root):
+        source_(source),
+        fileNameStyle_(fileNameStyle),
+        root_(root),
+        topLevelDepth_(1),
+        topLevelNodes_(0),
+        isRootExplicit_(false),
+        hasRootError_(false)
+    {
+        stack_.push_back(Frame(0, 0, 0));
+    }
+    bool startNode(const char* name, size_t size)
+    {
+        if(topLevelDepth_ == stack_.size())
+            return startTopLevelNode(name, size);
+        return startChild(name, size);
+    }
+    void attribute(const char* name, size_t nameSize, const char* value, size_t valueSize)
+    {
+        attributes_.push_back(std::make_pair(name, nameSize));
+        stack_.back().tree->push_back(ValueType(std::string(name, nameSize), Tree(std::string(value, valueSize))));
+    }
+    void endAttributes()
+    {
+        assert(stack_.back().tree->size() == attributes_.size());//...there are no other children yet
+        if(attributeError_.empty() && hasDuplicateChildren(*stack_.back().tree))
+            checkUniqueAttributes();
+        stack_.back().attributes = attributes_.size();
+        attributes_.clear();
+    }
+    void appendData(const char* data, size_t size)
+    {
+        if(topLevelDepth_ == stack_.size())
+            documentData_.append(data, size);
+        else
+            stack_.back().tree->data().append(data, size);
+    }
+    void endNode()
+    {
+        assert(stack_.size() > topLevelDepth_);
+        const Frame& frame(stack_.back());
+        if(frame.attributes && frame.tree->size() > frame.attributes)
+            reorderAttributes(*frame.tree, frame.attributes);
+        stack_.pop_back();
+    }
+    void finish()
+    {
+        assert(stack_.size() == topLevelDepth_);
+        if(0 == topLevelNodes_)
+            source_.throwEmptySourceError();
+        if(!attributeError_.empty())
+            throw ConfigError(attributeError_);
+        if(hasRootError_)
+            throwRootError();
+        if(isRootExplicit_)
+            root_.data().swap(documentData_);
+        else
+            root_.front().second.data().swap(documentData_);
+        source_.normalizeKeywords(root_, fileNameStyle_);
+        source_.normalizeInstanceDelimiter(root_);
+    }
+private:
+    //...level of the node for the filter, children of OtherNode are never filtered
+    enum NodeKind { OtherNode, RootNode, AppNode, InstancesNode, SkippedNode };
+    struct Frame
+    {
+        Frame(Tree* tree_, const char* rawName_, size_t rawNameSize_, NodeKind kind_ = OtherNode):
+            tree(tree_), rawName(rawName_), rawNameSize(rawNameSize_), attributes(0), kind(kind_)
+        {}
+        Tree* tree;
+        const char* rawName;//...name as it is in the source, it is used only in error messages
+        size_t rawNameSize;
+        size_t attributes;//...attributes are the first children of the node
+        NodeKind kind;
+    };
+    typedef std::pair<const char*, size_t> RawName;
+    bool startTopLevelNode(const char* name, size_t size)
+    {
+        const bool isRoot = isKeyword(name, size, ROOT_NODE_NAME);
+        const NodeKind configKind = source_.filter() ? RootNode : OtherNode;
+        if(0 == topLevelNodes_++)
+        {
+            Tree& config = root_.push_back(ValueType(ROOT_NODE_NAME, Tree()))->second;
+            if(isRoot)
+            {
+                isRootExplicit_ = true;
+                stack_.push_back(Frame(&config, name, size, configKind));
+                return true;
+            }
+            stack_.push_back(Frame(&config, 0, 0, configKind));//...implicit 'config' node isn't a part of names in messages
+            ++topLevelDepth_;
+        }
+        else if(isRoot || isRootExplicit_)
+            hasRootError_ = true;
+        if(hasRootError_)
+        {//...continue reading into scratch tree to report syntax errors first
+            scratch_.clear();
+            stack_.push_back(Frame(&scratch_, name, size));
+            return true;
+        }
+        return startChild(name, size);
+    }
+    bool startChild(const char* name, size_t size)
+    {
+        const NodeKind kind = OtherNode == stack_.back().kind ? OtherNode : filterNode(name, size);
+        if(SkippedNode == kind)
+            return false;
+        Tree& child = stack_.back().tree->push_back(ValueType(std::string(name, size), Tree()))->second;
+        stack_.push_back(Frame(&child, name, size, kind));
+        return true;
+    }
+    NodeKind filterNode(const char* name, size_t size) const
+    {
+        const ConfigSource::Filter& filter(*source_.filter());
+        switch(stack_.back().kind)
+        {
+            case RootNode:
+            {
+                if(isKeyword(name, size, SHARED_NODE_NAME))
+                    return OtherNode;
+                const bool toLower = ConfigSource::CaseInsensitive == fileNameStyle_;
+                const char* delimiter = std::find(name, name + size, INSTANCE_DELIMITER_CHAR);
+                if(!isNormalizedName(name, delimiter - name, filter.appName, toLower))
+                    return SkippedNode;
+                if(name + size == delimiter)
+                    return AppNode;
+                //...abbreviated 'app:instance' node
+                return isNormalizedName(delimiter + 1, name + size - delimiter - 1, filter.instanceName, toLower) ?
+                    OtherNode : SkippedNode;
+            }
+            case AppNode:
+                return isKeyword(name, size, INSTANCE_NODE_NAME) ? InstancesNode : OtherNode;
+            case InstancesNode:
+                return isNormalizedName(name, size, filter.instanceName, false) ? OtherNode : SkippedNode;
+            default:
+                return OtherNode;
+        }
+    }
+    //...read_xml path adds attributes after all children. This affects only order of nodes with
+    //...the same name in ptree index (so what find() returns), so the order is restored only for them.
+    static void reorderAttributes(Tree& tree, size_t attributes)
+    {
+        Iter iter(tree.begin());
+        for(size_t i = 0; i != attributes; ++i)
+        {
+            if(tree.count(iter->first) > 1)
+            {
+                const Iter newIter = tree.insert(iter, ValueType(iter->first, Tree()));
+                newIter->second.swap(iter->second);
+                tree.erase(iter);
+                iter = newIter;
+            }
+            ++iter;
+        }
+    }
+    void checkUniqueAttributes()
+    {//...the same attribute is reported as in copyUniqueChildren
+        for(std::vector<RawName>::const_reverse_iterator iter = attributes_.rbegin(); attributes_.rend() != iter; ++iter)
+        {
+            size_t count = 0;
+            BOOST_FOREACH(const RawName& name, attributes_)
+            {
+                if(name.second == iter->second && std::equal(name.first, name.first + name.second, iter->first))
+                    ++count;
+            }
+            if(count > 1)
+            {
+                std::string path;
+                BOOST_FOREACH(const Frame& frame, stack_)
+                {
+                    if(!frame.rawName)
+                        continue;
+                    path.append(frame.rawName, frame.rawNameSize);
+                    path += '.';
+                }
+                path.append(iter->first, iter->second);
+                attributeError_ = str(
+                    boost::format("Duplicate definition of attribute '%1%' in config '%2%'") %
+                        path %
+                        source_.name());
+                return;
+            }
+        }
+    }
+    void throwRootError() const
+    {
+        throw ConfigError(str(
+            boost::format("Invalid config source '%1%'. '" ROOT_NODE_NAME "' must be root node") %
+            source_.name()));
+    }
+    //...
+    const Impl& source_;
+    const ConfigSource::FileNameStyle fileNameStyle_;
+    Tree& root_;
+    std::vector<Frame> stack_;
+    std::vector<RawName> attributes_;
+    std::string documentData_;
+    std::string attributeError_;
+    Tree scratch_;
+    size_t topLevelDepth_;//...implicit 'config' node stays in the stack
+    size_t topLevelNodes_;
+    bool isRootExplicit_;
+    bool hasRootError_;
+};
+
 ConfigSource::Impl::Impl(
     std::istream& input,
     const std::string& name,
     ConfigSource::Format format,
-    ConfigSource::FileNameStyle fileNameStyle):
+    ConfigSource::FileNameStyle fileNameStyle,
+    ConfigSource::ParserMode parserMode,
+    const ConfigSource::Filter* filter):
     name_(name)
 {
+    if(filter)
+    {
+        filter_ = *filter;
+        if(ConfigSource::DefaultParser == parserMode)
+            parserMode = ConfigSource::SinglePassParser;
+    }
     switch (format)
     {
         case ConfigSource::xml:
+            if(ConfigSource::DefaultParser != parserMode)
+            {
+                readSource(input, std::string(), format, fileNameStyle);
+                break;
+            }
             PT::read_xml(input, root_, PT::xml_parser::trim_whitespace);
             normalizeXmlAttributes(root_);
+            normalizeRawTree(fileNameStyle);
+            break;
+        case ConfigSource::json:
+            readSource(input, std::string(), format, fileNameStyle);
             break;
         default:
-            ConfigError(
+            throw ConfigError(
                 boost::str(
                     boost::format("Parsing of config format %1% is not implemented") %
                     format));
     }
-    processRawTree(fileNameStyle);
+    validate();
 }
 
 ConfigSource::Impl::Impl(
     const std::string& filename,
     ConfigSource::Format format,
-    ConfigSource::FileNameStyle fileNameStyle):
+    ConfigSource::FileNameStyle fileNameStyle,
+    ConfigSource::ParserMode parserMode,
+    const ConfigSource::Filter* filter):
     name_(filename)
 {
+    if(filter)
+    {
+        filter_ = *filter;
+        if(ConfigSource::DefaultParser == parserMode)
+            parserMode = ConfigSource::SinglePassParser;
+    }
     switch (format)
     {
         case ConfigSource::xml:
+            if(ConfigSource::DefaultParser != parserMode)
+            {
+                readFile(filename, format, fileNameStyle, parserMode);
+                break;
+            }
             PT::read_xml(filename, root_, PT::xml_parser::trim_whitespace);
             normalizeXmlAttributes(root_);
+            normalizeRawTree(fileNameStyle);
+            break;
+        case ConfigSource::json:
+            readFile(filename, format, fileNameStyle, parserMode);
             break;
         default:
-            ConfigError(
+            throw ConfigError(
                 boost::str(
                     boost::format("Parsing of config format %1% is not implemented") %
                     format));
     }
-    processRawTree(fileNameStyle);
+    validate();
 }
 
-void ConfigSource::Impl::processRawTree(ConfigSource::FileNameStyle fileNameStyle)
+ConfigSource::Impl::Impl(
+    const char* begin,
+    const char* end,
+    const std::string& name,
+    ConfigSource::Format format,
+    ConfigSource::FileNameStyle fileNameStyle,
+    ConfigSource::ParserMode parserMode,
+    const ConfigSource::Filter* filter):
+    name_(name)
+{
+    if(filter)
+    {
+        filter_ = *filter;
+        if(ConfigSource::DefaultParser == parserMode)
+            parserMode = ConfigSource::SinglePassParser;
+    }
+    switch (format)
+    {
+        case ConfigSource::xml:
+            if(ConfigSource::DefaultParser != parserMode)
+            {
+                parseSource(begin, end, std::string(), format, fileNameStyle);
+                break;
+            }
+            {
+                MemoryBuffer buffer(begin, end);
+                std::istream input(&buffer);
+                PT::read_xml(input, root_, PT::xml_parser::trim_whitespace);
+            }
+            normalizeXmlAttributes(root_);
+            normalizeRawTree(fileNameStyle);
+            break;
+        case ConfigSource::json:
+            parseSource(begin, end, std::string(), format, fileNameStyle);
+            break;
+        default:
+            throw ConfigError(
+                boost::str(
+                    boost::format("Parsing of config format %1% is not implemented") %
+                    format));
+    }
+    validate();
+}
+
+ConfigSource::Impl::Impl(const std::string& name, Tree& root):
+    name_(name)
+{
+    root_.swap(root);
+}
+
+void ConfigSource::Impl::readFile(
+    const std::string& filename,
+    ConfigSource::Format format,
+    ConfigSource::FileNameStyle fileNameStyle,
+    ConfigSource::ParserMode parserMode)
+{
+    if(ConfigSource::MappedFileParser == parserMode && mapFile(filename, format, fileNameStyle))
+        return;
+    std::ifstream input(filename.c_str(), std::ios::in | std::ios::binary);
+    if(!input)
+        throw PT::file_parser_error("cannot open file", filename, 0);
+    readSource(input, filename, format, fileNameStyle);
+}
+
+//...returns false if file can't be mapped (it's empty, it's a pipe, etc.), then it must be read as a stream
+bool ConfigSource::Impl::mapFile(
+    const std::string& filename,
+    ConfigSource::Format format,
+    ConfigSource::FileNameStyle fileNameStyle)
+{
+    namespace IP = boost::interprocess;
+    IP::mapped_region region;
+    try
+    {
+        const IP::file_mapping file(filename.c_str(), IP::read_only);
+        IP::mapped_region(file, IP::read_only).swap(region);
+    }
+    catch(const IP::interprocess_exception&)
+    {
+        return false;
+    }
+    region.advise(IP::mapped_region::advice_sequential);
+    const char* begin = static_cast<const char*>(region.get_address());
+    parseSource(begin, begin + region.get_size(), filename, format, fileNameStyle);
+    return true;
+}
+
+void ConfigSource::Impl::readSource(
+    std::istream& input,
+    const std::string& fileName,
+    ConfigSource::Format format,
+    ConfigSource::FileNameStyle fileNameStyle)
+{
+    const std::string buffer(
+        (std::istreambuf_iterator<char>(input)),
+        std::istreambuf_iterator<char>());
+    if(input.bad())
+        throw PT::file_parser_error("read error", fileName, 0);
+    parseSource(buffer.data(), buffer.data() + buffer.size(), fileName, format, fileNameStyle);
+}
+
+void ConfigSource::Impl::parseSource(
+    const char* begin,
+    const char* end,
+    const std::string& fileName,
+    ConfigSource::Format format,
+    ConfigSource::FileNameStyle fileNameStyle)
+{
+    TreeBuilder builder(*this, fileNameStyle, root_);
+    if(ConfigSource::json == format)
+        JsonReader<TreeBuilder>(begin, end, fileName, builder).read();
+    else
+        XmlReader<TreeBuilder>(begin, end, fileName, builder).read();
+    builder.finish();
+}
+
+void ConfigSource::Impl::normalizeRawTree(ConfigSource::FileNameStyle fileNameStyle)
 {
     if (root_.empty())
-        throw ConfigSource(str(
-            boost::format("Config source '%1%' is empty") % name()));
+        throwEmptySourceError();
 
     normalizeRootNode(root_);
     normalizeKeywords(root_, fileNameStyle);
     normalizeInstanceDelimiter(root_);
-    
-    const Validator validator(name(), root_);
-    validator.checkNoDataInConfigNode();
-    validator.checkNoDataInSharedNode();
-    validator.checkNoDataInAppAndInstanceNode();
-    validator.checkTreeDoesNotHaveDataAndAttributeNodes();
-    validator.checkNoSharedNodeDuplicates();
-    validator.checkNoSharedSubnodeDuplicates();
-    validator.checkNoSharedInstanceNode();
-    validator.checkNoDirectSharedAttributes();
-    validator.checkNoAppNodeDuplicates();
-    validator.checkNoInstanceNodeDuplicates();
-    validator.checkNoInstanceSubnodeDuplicates();
-}
-
-std::string ConfigSource::Impl::toString(bool pretty) const
-{
-    std::stringstream strm;
-    if(pretty)
-        PT::write_xml(strm, root_, PT::xml_writer_make_settings(' ', 2));
+}
+
+void ConfigSource::Impl::validate() const
+{
+    Validator(name(), root_).validate();
+}
+
+void ConfigSource::Impl::throwEmptySourceError() const
+{
+    throw ConfigError(str(
+        boost::format("Couldn't parse config '%1%'. Reason: config source is empty") % name()));
+}
+
+void ConfigSource::Impl::write(std::ostream& os, bool pretty, ConfigSource::Format format) const
+{
+    if(ConfigSource::json == format)
+        JsonWriter(os, pretty).write(root_);
     else
-        PT::write_xml(strm, root_);
-    std::string firstString;
-    std::getline(strm, firstString);
-    if(firstString.size() > 2 && //...get rid of the first line with <?xml ...?>
-        '<' == firstString[0] && '?' == firstString[1])
-        return strm.str().substr(firstString.size() + 1);
-    return strm.str();
+        XmlWriter(os, pretty).write(root_);
 }
 
 void ConfigSource::Impl::normalizeXmlAttributes(Tree& rawTree) const
 {
     if (rawTree.empty())
-        throw ConfigSource(str(
-            boost::format("Config source '%1%' is empty") % name()));
+        throwEmptySourceError();
     
     normalizeXmlAttributesImpl(Path(), rawTree);
 }
@@ -351,12 +821,12 @@ void ConfigSource::Impl::normalizeXmlAttributesImpl(const Path& currentPath, Tre
 
 void ConfigSource::Impl::normalizeRootNode(Tree& rawTree) const
 {
-    if(rawTree.size() == 1 && ROOT_NODE_NAME == boost::to_lower_copy(rawTree.front().first))
+    if(rawTree.size() == 1 && isKeyword(rawTree.front().first, ROOT_NODE_NAME))
         return;//...this tree is already normalized
     BOOST_FOREACH(const Tree::value_type& child, rawTree)
     {
         const std::string& childName = child.first;
-        if(ROOT_NODE_NAME == boost::to_lower_copy(childName))
+        if(isKeyword(childName, ROOT_NODE_NAME))
             throw ConfigError(str(
                 boost::format("Invalid config source '%1%'. '" ROOT_NODE_NAME "' must be root node") %
                 name()));
@@ -382,7 +852,7 @@ void ConfigSource::Impl::normalizeKeywords(
     Tree& root, ConfigSource::FileNameStyle fileNameStyle) const
 {
     const std::string& rootName(root.front().first);
-    assert(ROOT_NODE_NAME == boost::to_lower_copy(rootName));
+    assert(isKeyword(rootName, ROOT_NODE_NAME));
     if(ROOT_NODE_NAME != rootName)
         renameNode(root, root.begin(), ROOT_NODE_NAME);
     Tree& configNode = root.front().second;
@@ -395,7 +865,7 @@ void ConfigSource::Impl::normalizeKeywords(
 Iter ConfigSource::Impl::normalizeKeywordsImpl(
     Tree& parent, const Iter& childIter, ConfigSource::FileNameStyle fileNameStyle) const
 {
-    if(SHARED_NODE_NAME == boost::to_lower_copy(childIter->first))
+    if(isKeyword(childIter->first, SHARED_NODE_NAME))
     {
         if(SHARED_NODE_NAME != childIter->first)
             return renameNode(parent, childIter, SHARED_NODE_NAME);
@@ -406,7 +876,7 @@ Iter ConfigSource::Impl::normalizeKeywordsImpl(
         for(Iter iter = appNode.begin(); appNode.end() != iter; ++iter)
         {
             const std::string& nodeName = iter->first;
-            if(INSTANCE_NODE_NAME == boost::to_lower_copy(nodeName))
+            if(isKeyword(nodeName, INSTANCE_NODE_NAME))
             {
                 if(INSTANCE_NODE_NAME != nodeName)
                     iter = renameNode(appNode, iter, INSTANCE_NODE_NAME);
@@ -467,7 +937,7 @@ Iter ConfigSource::Impl::normalizeInstanceDelimiterImpl(
                 "instanceName'") %
                 childName %
                 name()));
-    if(boost::to_lower_copy(appName) == SHARED_NODE_NAME)
+    if(isKeyword(appName, SHARED_NODE_NAME))
         throw ConfigError(str(
             boost::format("Shared node '%1%' can't have instance. Found in config source '%2%'") %
             childName %
@@ -490,26 +960,28 @@ Iter ConfigSource::Impl::normalizeInstanceDelimiterImpl(
 
 void ConfigSource::Impl::copyUniqueChildren(const Path& currentPath, const Tree& from, Tree& to) const
 {
-    BOOST_REVERSE_FOREACH(const Tree::value_type& node, from)
-    {
-        if(from.count(node.first) > 1)
-            throw ConfigError(str(
-                boost::format("Duplicate definition of attribute '%1%' in config '%2%'") %
-                    (currentPath/Path(node.first)).dump() %
-                    name()));
-        to.push_front(node);
+    if(hasDuplicateChildren(from))
+    {//...report the last attribute which has a duplicate
+        BOOST_REVERSE_FOREACH(const Tree::value_type& node, from)
+        {
+            if(from.count(node.first) > 1)
+                throw ConfigError(str(
+                    boost::format("Duplicate definition of attribute '%1%' in config '%2%'") %
+                        (currentPath/Path(node.first)).dump() %
+                        name()));
+        }
     }
+    to.insert(to.begin(), from.begin(), from.end());
 }
 
 ConfigSource::ConfigSource(
     const std::string& source,
     const std::string& name,
     Format format,
-    FileNameStyle fileNameStyle) try
+    FileNameStyle fileNameStyle,
+    ParserMode parserMode) try :
+    impl_(new Impl(source.data(), source.data() + source.size(), name, format, fileNameStyle, parserMode))
 {
-    std::stringstream strm;
-    strm << source;
-    impl_.reset(new Impl(strm, name, format, fileNameStyle));
 }
 catch(const PT::ptree_error& ex)
 {
@@ -523,8 +995,9 @@ ConfigSource::ConfigSource(
     std::istream& source,
     const std::string& name,
     Format format,
-    FileNameStyle fileNameStyle) try :
-    impl_(new Impl(source, name, format, fileNameStyle))
+    FileNameStyle fileNameStyle,
+    ParserMode parserMode) try :
+    impl_(new Impl(source, name, format, fileNameStyle, parserMode))
 {
 }
 catch(const PT::ptree_error& ex)
@@ -539,15 +1012,87 @@ catch(const PT::ptree_error& ex)
             ex.what()));
 }
 
+ConfigSource::ConfigSource(
+    const std::string& source,
+    const Filter& filter,
+    const std::string& name,
+    Format format,
+    FileNameStyle fileNameStyle) try :
+    impl_(new Impl(source.data(), source.data() + source.size(), name, format, fileNameStyle, SinglePassParser, &filter))
+{
+}
+catch(const PT::ptree_error& ex)
+{
+    throw ConfigError(str(
+        boost::format("Couldn't parse config '%1%'. Reason: %2%") %
+        name %
+        ex.what()));
+}
+
+ConfigSource::ConfigSource(
+    std::istream& source,
+    const Filter& filter,
+    const std::string& name,
+    Format format,
+    FileNameStyle fileNameStyle) try :
+    impl_(new Impl(source, name, format, fileNameStyle, SinglePassParser, &filter))
+{
+}
+catch(const PT::ptree_error& ex)
+{
+    throw ConfigError(str(
+        boost::format("Couldn't parse config '%1%'. Reason: %2%") %
+        name %
+        ex.what()));
+}
+
+ConfigSource::ConfigSource(
+    const char* data,
+    size_t size,
+    const std::string& name,
+    Format format,
+    FileNameStyle fileNameStyle,
+    ParserMode parserMode) try :
+    impl_(new Impl(data, data + size, name, format, fileNameStyle, parserMode))
+{
+}
+catch(const PT::ptree_error& ex)
+{
+    throw ConfigError(str(
+        boost::format("Couldn't parse config '%1%'. Reason: %2%") %
+        name %
+        ex.what()));
+}
+
+ConfigSource::ConfigSource(
+    const char* data,
+    size_t size,
+    const Filter& filter,
+    const std::string& name,
+    Format format,
+    FileNameStyle fileNameStyle) try :
+    impl_(new Impl(data, data + size, name, format, fileNameStyle, SinglePassParser, &filter))
+{
+}
+catch(const PT::ptree_error& ex)
+{
+    throw ConfigError(str(
+        boost::format("Couldn't parse config '%1%'. Reason: %2%") %
+        name %
+        ex.what()));
+}
+
 ConfigSource::ConfigSource(const boost::shared_ptr<Impl>& impl): impl_(impl) {}
 
 
 ConfigSource::~ConfigSource() {}
 
+const std::string& ConfigSource::name() const { return impl_->name(); }
+
 ConfigSource ConfigSource::createFromFile(
-    const std::string& filename, Format format, FileNameStyle fileNameStyle) try
+    const std::string& filename, Format format, FileNameStyle fileNameStyle, ParserMode parserMode) try
 {
-    const boost::shared_ptr<Impl> impl(new Impl(filename, format, fileNameStyle));
+    const boost::shared_ptr<Impl> impl(new Impl(filename, format, fileNameStyle, parserMode));
     return ConfigSource(impl);
 }
 catch(const PT::ptree_error& ex)
@@ -560,13 +1105,168 @@ catch(const PT::ptree_error& ex)
                 ex.what()));
 }
 
-std::string ConfigSource::toString(OutputType outputType) const try
+ConfigSource ConfigSource::createFromFile(
+    const std::string& filename,
+    const Filter& filter,
+    Format format,
+    FileNameStyle fileNameStyle,
+    ParserMode parserMode) try
 {
-    return impl_->toString(Pretty == outputType);
+    const boost::shared_ptr<Impl> impl(new Impl(filename, format, fileNameStyle, parserMode, &filter));
+    return ConfigSource(impl);
 }
 catch(const PT::ptree_error& ex)
 {
-    throw ConfigSource(
+    throw ConfigError(
+        boost::str(
+            boost::format(
+                "Couldn't parse config '%1%'. Reason: %2%") %
+                filename %
+                ex.what()));
+}
+
+namespace
+{
+
+//...every worker takes the next file which is not loaded yet, so a big file doesn't hold up the others
+class FileLoader: boost::noncopyable
+{
+public:
+    FileLoader(
+        const std::vector<std::string>& filenames,
+        ConfigSource::Format format,
+        ConfigSource::FileNameStyle fileNameStyle,
+        ConfigSource::ParserMode parserMode):
+        filenames_(filenames),
+        format_(format),
+        fileNameStyle_(fileNameStyle),
+        parserMode_(parserMode),
+        sources_(filenames.size()),
+        errors_(filenames.size()),
+        next_(0)
+    {}
+    ConfigSources load()
+    {
+        const size_t workers = std::min<size_t>(
+            std::max(1u, boost::thread::hardware_concurrency()),
+            filenames_.size());
+        if(workers > 1)
+        {
+            boost::thread_group threads;
+            for(size_t i = 1; i != workers; ++i)
+                threads.create_thread(boost::bind(&FileLoader::work, this));
+            work();
+            threads.join_all();
+        }
+        else
+            work();
+        //...report error of the first failed file, so it doesn't depend on scheduling
+        ConfigSources result;
+        result.reserve(filenames_.size());
+        for(size_t i = 0; i != filenames_.size(); ++i)
+        {
+            if(!sources_[i])
+                throw ConfigError(errors_[i]);
+            result.push_back(*sources_[i]);
+        }
+        return result;
+    }
+private:
+    void work()
+    {
+        for(size_t index = nextIndex(); index != filenames_.size(); index = nextIndex())
+        {
+            try
+            {
+                sources_[index] = ConfigSource::createFromFile(
+                    filenames_[index], format_, fileNameStyle_, parserMode_);
+            }
+            catch(const ConfigError& ex)
+            {
+                errors_[index] = ex.what();
+            }
+            catch(const std::exception& ex)
+            {
+                errors_[index] = str(
+                    boost::format("Couldn't parse config '%1%'. Reason: %2%") %
+                    filenames_[index] %
+                    ex.what());
+            }
+        }
+    }
+    size_t nextIndex()
+    {
+        const boost::lock_guard<boost::mutex> guard(mutex_);
+        if(filenames_.size() != next_)
+            return next_++;
+        return next_;
+    }
+    //...
+    const std::vector<std::string>& filenames_;
+    const ConfigSource::Format format_;
+    const ConfigSource::FileNameStyle fileNameStyle_;
+    const ConfigSource::ParserMode parserMode_;
+    std::vector<boost::optional<ConfigSource> > sources_;
+    std::vector<std::string> errors_;
+    boost::mutex mutex_;
+    size_t next_;
+};
+
+}//anonymous namespace
+
+ConfigSources ConfigSource::createFromFiles(
+    const std::vector<std::string>& filenames,
+    Format format,
+    FileNameStyle fileNameStyle,
+    ParserMode parserMode)
+{
+    return FileLoader(filenames, format, fileNameStyle, parserMode).load();
+}
+
+ConfigSources ConfigSource::createFromDirectory(
+    const std::string& directory,
+    Format format,
+    FileNameStyle fileNameStyle,
+    ParserMode parserMode)
+{
+    namespace FS = boost::filesystem;
+    const std::string extension(json == format ? ".json" : ".xml");
+    std::vector<std::string> filenames;
+    try
+    {
+        for(FS::directory_iterator iter(directory), end; end != iter; ++iter)
+        {
+            if(FS::is_regular_file(iter->status()) && extension == iter->path().extension().string())
+                filenames.push_back(iter->path().string());
+        }
+    }
+    catch(const FS::filesystem_error& ex)
+    {
+        throw ConfigError(
+            boost::str(
+                boost::format(
+                    "Couldn't read config directory '%1%'. Reason: %2%") %
+                    directory %
+                    ex.what()));
+    }
+    std::sort(filenames.begin(), filenames.end());
+    return createFromFiles(filenames, format, fileNameStyle, parserMode);
+}
+
+std::string ConfigSource::toString(OutputType outputType, Format format) const
+{
+    std::ostringstream strm;
+    write(strm, outputType, format);
+    return strm.str();
+}
+
+void ConfigSource::write(std::ostream& os, OutputType outputType, Format format) const try
+{
+    impl_->write(os, Pretty == outputType, format);
+}
+catch(const PT::ptree_error& ex)
+{
+    throw ConfigError(
         boost::str(
             boost::format(
                 "Couldn't stringify config '%1%'. Reason: %2%") %
@@ -9,8 +9,11 @@
 #ifndef JetConfig_ConfigSource_hpp
 #define JetConfig_ConfigSource_hpp
 
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/move/core.hpp>
 #include <boost/shared_ptr.hpp>
 #include <string>
+#include <vector>
 #include <iosfwd>
 
 namespace jet
@@ -18,35 +21,109 @@ namespace jet
 
 class ConfigSource
 {
+    BOOST_COPYABLE_AND_MOVABLE(ConfigSource)//...only to be merged with boost::move, see Config::operator<<
     class Impl;
     explicit ConfigSource(const boost::shared_ptr<Impl>& impl);
 public:
     enum Format{ xml, json };
     enum OutputType { Pretty, OneLine };
     enum FileNameStyle { CaseSensitive, CaseInsensitive };
+    enum ParserMode
+    {
+        DefaultParser,   //...PT::read_xml followed by normalization passes over the whole tree
+        SinglePassParser,//...normalized tree is built while xml is being tokenized (json is always parsed this way)
+        MappedFileParser //...the same as SinglePassParser, but createFromFile tokenizes memory-mapped file in place
+    };
+    //...Selects only nodes which Config(appName, instanceName) merges: 'shared', application node and node of
+    //...the instance (if instanceName isn't empty). Other nodes are skipped by tokenizer, so they are neither
+    //...built nor validated. Filtered source is always parsed in a single pass and it can be merged only
+    //...into config with the same application and instance names.
+    struct Filter
+    {
+        explicit Filter(const std::string& appName_, const std::string& instanceName_ = std::string()):
+            appName(boost::trim_copy(appName_)), instanceName(boost::trim_copy(instanceName_))
+        {}
+        std::string appName;
+        std::string instanceName;
+    };
     //...
     explicit ConfigSource(
         const std::string& source,
         const std::string& name = "unknown",
         Format format = xml,
-        FileNameStyle = CaseSensitive);
+        FileNameStyle = CaseSensitive,
+        ParserMode = DefaultParser);
     explicit ConfigSource(
         std::istream& source,
         const std::string& name = "unknown",
         Format format = xml,
+        FileNameStyle = CaseSensitive,
+        ParserMode = DefaultParser);
+    //...buffer is parsed in place, it must stay valid only during the call
+    ConfigSource(
+        const char* data,
+        size_t size,
+        const std::string& name = "unknown",
+        Format format = xml,
+        FileNameStyle = CaseSensitive,
+        ParserMode = DefaultParser);
+    ConfigSource(
+        const char* data,
+        size_t size,
+        const Filter& filter,
+        const std::string& name = "unknown",
+        Format format = xml,
+        FileNameStyle = CaseSensitive);
+    ConfigSource(
+        const std::string& source,
+        const Filter& filter,
+        const std::string& name = "unknown",
+        Format format = xml,
+        FileNameStyle = CaseSensitive);
+    ConfigSource(
+        std::istream& source,
+        const Filter& filter,
+        const std::string& name = "unknown",
+        Format format = xml,
         FileNameStyle = CaseSensitive);
+    ConfigSource(const ConfigSource& source): impl_(source.impl_) {}
     ~ConfigSource();
+    ConfigSource& operator=(BOOST_COPY_ASSIGN_REF(ConfigSource) source) { impl_ = source.impl_; return *this; }
     static ConfigSource createFromFile(
         const std::string& filename,
         Format format = xml,
-        FileNameStyle = CaseSensitive);
+        FileNameStyle = CaseSensitive,
+        ParserMode = DefaultParser);
+    static ConfigSource createFromFile(
+        const std::string& filename,
+        const Filter& filter,
+        Format format = xml,
+        FileNameStyle = CaseSensitive,
+        ParserMode = MappedFileParser);
+    //...files are parsed and validated concurrently, result is in the same order as filenames
+    static std::vector<ConfigSource> createFromFiles(
+        const std::vector<std::string>& filenames,
+        Format format = xml,
+        FileNameStyle = CaseSensitive,
+        ParserMode = DefaultParser);
+    //...loads all '*.xml' (or '*.json') files of the directory like conf.d, result is sorted by file name
+    static std::vector<ConfigSource> createFromDirectory(
+        const std::string& directory,
+        Format format = xml,
+        FileNameStyle = CaseSensitive,
+        ParserMode = DefaultParser);
     const std::string& name() const;
-    std::string toString(OutputType outputType = Pretty) const;
+    std::string toString(OutputType outputType = Pretty, Format format = xml) const;
+    //...normalized source is written straight to the stream, xml is written without '<?xml ...?>' declaration
+    void write(std::ostream& os, OutputType outputType = Pretty, Format format = xml) const;
 private:
     boost::shared_ptr<Impl> impl_;
     friend class ConfigNode;
+    friend class ConfigSourceCache;
 };
 
+typedef std::vector<ConfigSource> ConfigSources;
+
 }//namespace jet
 
 #endif /*JetConfig_ConfigSource_hpp*/
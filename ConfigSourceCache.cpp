@@ -0,0 +1,309 @@
+//
+//  ConfigSourceCache.cpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+#include "ConfigSourceCache.hpp"
+#include "ConfigSourceImpl.hpp"
+#include "ConfigImage.hpp"
+#include "ConfigError.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/format.hpp>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+
+namespace PT = boost::property_tree;
+typedef PT::ptree Tree;
+
+#define CACHE_ENTRY_MAGIC "JETPCACH"
+#define CACHE_ENTRY_VERSION 1
+
+namespace jet
+{
+
+namespace
+{
+
+typedef boost::uint64_t Hash;
+
+//...FNV-1a over 64 bit words, it is fast enough to be computed on every load
+Hash hashContent(const char* data, size_t size)
+{
+    Hash hash = UINT64_C(14695981039346656037) ^ size;
+    for(; size >= sizeof(Hash); data += sizeof(Hash), size -= sizeof(Hash))
+    {
+        Hash word;
+        std::memcpy(&word, data, sizeof(word));
+        hash = (hash ^ word) * UINT64_C(1099511628211);
+        hash ^= hash >> 29;
+    }
+    for(; size > 0; ++data, --size)
+        hash = (hash ^ static_cast<unsigned char>(*data)) * UINT64_C(1099511628211);
+    return hash;
+}
+
+struct FileIdentity
+{
+    boost::uint64_t device;
+    boost::uint64_t inode;
+    boost::uint64_t modificationSeconds;
+    boost::uint64_t modificationNanoseconds;
+    boost::uint64_t size;
+    Hash contentHash;
+};
+
+//...content hash isn't compared, it's enough to find out that file has been changed
+bool isSameFile(const FileIdentity& lhs, const FileIdentity& rhs)
+{
+    return
+        lhs.device == rhs.device &&
+        lhs.inode == rhs.inode &&
+        lhs.modificationSeconds == rhs.modificationSeconds &&
+        lhs.modificationNanoseconds == rhs.modificationNanoseconds &&
+        lhs.size == rhs.size;
+}
+
+//...file which has been changed shortly before its entry was written can be changed again without change of its
+//...modification time, if timestamps of the file system are coarse. Content of such file is compared by hash
+bool isRacy(const FileIdentity& file, const FileIdentity& entry)
+{
+    return file.modificationSeconds + 2 >= entry.modificationSeconds;
+}
+
+//...identity without content hash
+boost::optional<FileIdentity> statFile(const std::string& filename)
+{
+    struct stat status;
+    if(::stat(filename.c_str(), &status) || !S_ISREG(status.st_mode))
+        return boost::none;
+    FileIdentity identity = {};
+    identity.device = status.st_dev;
+    identity.inode = status.st_ino;
+    identity.modificationSeconds = status.st_mtime;
+#if defined(__APPLE__)
+    identity.modificationNanoseconds = status.st_mtimespec.tv_nsec;
+#else
+    identity.modificationNanoseconds = status.st_mtim.tv_nsec;
+#endif
+    identity.size = status.st_size;
+    return identity;
+}
+
+boost::optional<FileIdentity> identifyFile(const std::string& filename)
+{
+    namespace IP = boost::interprocess;
+    boost::optional<FileIdentity> identity(statFile(filename));
+    if(!identity || !identity->size)
+        return identity;
+    try
+    {
+        const IP::file_mapping file(filename.c_str(), IP::read_only);
+        const IP::mapped_region region(file, IP::read_only);
+        identity->contentHash = hashContent(static_cast<const char*>(region.get_address()), region.get_size());
+        if(region.get_size() != identity->size)
+            return boost::none;//...file is being changed
+    }
+    catch(const IP::interprocess_exception&)
+    {
+        return boost::none;
+    }
+    return identity;
+}
+
+//...entry file is the header, source name padded to 8 bytes and then the image of source tree
+struct EntryHeader
+{
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t format;
+    boost::uint32_t fileNameStyle;
+    boost::uint32_t nameSize;
+    FileIdentity identity;
+};
+
+inline size_t imageOffset(size_t nameSize)
+{
+    return sizeof(EntryHeader) + (nameSize + 7) / 8 * 8;
+}
+
+}//anonymous namespace
+
+class ConfigSourceCache::Impl: boost::noncopyable
+{
+public:
+    explicit Impl(const std::string& directory): directory_(directory), hits_(0), misses_(0) {}
+    ConfigSource createFromFile(
+        const std::string& filename,
+        ConfigSource::Format format,
+        ConfigSource::FileNameStyle fileNameStyle,
+        ConfigSource::ParserMode parserMode)
+    {
+        const std::string entryFilename(getEntryFilename(filename, format, fileNameStyle));
+        if(const boost::optional<FileIdentity> status = statFile(filename))
+        {//...hit is checked by stat of the file, its content is read only if the entry is racy
+            const boost::shared_ptr<ConfigSource::Impl> source(
+                readEntry(entryFilename, filename, format, fileNameStyle, *status));
+            if(source)
+            {
+                count(hits_);
+                return ConfigSource(source);
+            }
+        }
+        count(misses_);
+        const boost::optional<FileIdentity> identity(identifyFile(filename));
+        const ConfigSource source(ConfigSource::createFromFile(filename, format, fileNameStyle, parserMode));
+        const boost::optional<FileIdentity> identityAfterParse(statFile(filename));
+        if(identity && identityAfterParse && isSameFile(*identity, *identityAfterParse))//...file wasn't changed while it was parsed
+            writeEntry(entryFilename, filename, format, fileNameStyle, *identity, *source.impl_);
+        return source;
+    }
+    unsigned long hits() const { return get(hits_); }
+    unsigned long misses() const { return get(misses_); }
+private:
+    std::string getEntryFilename(
+        const std::string& filename,
+        ConfigSource::Format format,
+        ConfigSource::FileNameStyle fileNameStyle) const
+    {
+        const std::string key(str(boost::format("%1%:%2%:%3%") % format % fileNameStyle % filename));
+        return (boost::filesystem::path(directory_) /
+            str(boost::format("%016x.cache") % hashContent(key.data(), key.size()))).string();
+    }
+    boost::shared_ptr<ConfigSource::Impl> readEntry(
+        const std::string& entryFilename,
+        const std::string& filename,
+        ConfigSource::Format format,
+        ConfigSource::FileNameStyle fileNameStyle,
+        const FileIdentity& status) const
+    {
+        boost::shared_ptr<ConfigSource::Impl> res;
+        const boost::optional<FileIdentity> entryStatus(statFile(entryFilename));
+        if(!entryStatus)
+            return res;
+        std::ifstream entry(entryFilename.c_str(), std::ios::in | std::ios::binary);
+        EntryHeader header;
+        if(!entry.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return res;
+        if(std::memcmp(header.magic, CACHE_ENTRY_MAGIC, sizeof(header.magic)) ||
+            CACHE_ENTRY_VERSION != header.version ||
+            static_cast<boost::uint32_t>(format) != header.format ||
+            static_cast<boost::uint32_t>(fileNameStyle) != header.fileNameStyle ||
+            filename.size() != header.nameSize ||
+            !isSameFile(status, header.identity))
+            return res;
+        std::string name(filename.size(), '\0');
+        if(!name.empty() && !entry.read(&name[0], name.size()))
+            return res;
+        if(name != filename)//...another file with the same hash of name
+            return res;
+        entry.close();
+        if(isRacy(status, *entryStatus))
+        {
+            const boost::optional<FileIdentity> identity(identifyFile(filename));
+            if(!identity || !isSameFile(*identity, status) || identity->contentHash != header.identity.contentHash)
+                return res;
+        }
+        try
+        {
+            const ConfigImage image(entryFilename, imageOffset(header.nameSize));
+            Tree root;
+            image.copyTo(image.root(), root);
+            res.reset(new ConfigSource::Impl(filename, root));
+        }
+        catch(const ConfigError&)
+        {//...broken entry is a miss, it will be overwritten
+        }
+        return res;
+    }
+    void writeEntry(
+        const std::string& entryFilename,
+        const std::string& filename,
+        ConfigSource::Format format,
+        ConfigSource::FileNameStyle fileNameStyle,
+        const FileIdentity& identity,
+        const ConfigSource::Impl& source) const
+    {//...entry is written to a unique temporary file and renamed, so concurrent readers and writers are safe
+        namespace FS = boost::filesystem;
+        EntryHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, CACHE_ENTRY_MAGIC, sizeof(header.magic));
+        header.version = CACHE_ENTRY_VERSION;
+        header.format = format;
+        header.fileNameStyle = fileNameStyle;
+        header.nameSize = static_cast<boost::uint32_t>(filename.size());
+        header.identity = identity;
+        FS::path tempFilename;
+        try
+        {
+            const ConfigImage image(source.getRoot(), std::string(), std::string());
+            tempFilename = FS::unique_path(entryFilename + ".%%%%-%%%%-%%%%.tmp");
+            {
+                std::ofstream entry(tempFilename.string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                entry.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                entry << filename;
+                entry.write("\0\0\0\0\0\0\0", imageOffset(filename.size()) - sizeof(header) - filename.size());
+                image.write(entry);
+                if(!entry.flush())
+                {
+                    entry.close();
+                    FS::remove(tempFilename);
+                    return;
+                }
+            }
+            FS::rename(tempFilename, entryFilename);
+        }
+        catch(const FS::filesystem_error&)
+        {//...temporary file isn't left behind if rename fails
+            if(!tempFilename.empty())
+            {
+                boost::system::error_code error;
+                FS::remove(tempFilename, error);
+            }
+        }
+        catch(const ConfigError&)
+        {//...source is too big for the image
+        }
+    }
+    void count(unsigned long& counter)
+    {
+        const boost::lock_guard<boost::mutex> guard(mutex_);
+        ++counter;
+    }
+    unsigned long get(const unsigned long& counter) const
+    {
+        const boost::lock_guard<boost::mutex> guard(mutex_);
+        return counter;
+    }
+    //...
+    const std::string directory_;
+    mutable boost::mutex mutex_;
+    unsigned long hits_;
+    unsigned long misses_;
+};
+
+ConfigSourceCache::ConfigSourceCache(const std::string& directory): impl_(new Impl(directory)) {}
+
+ConfigSourceCache::~ConfigSourceCache() {}
+
+ConfigSource ConfigSourceCache::createFromFile(
+    const std::string& filename,
+    ConfigSource::Format format,
+    ConfigSource::FileNameStyle fileNameStyle,
+    ConfigSource::ParserMode parserMode)
+{
+    return impl_->createFromFile(filename, format, fileNameStyle, parserMode);
+}
+
+unsigned long ConfigSourceCache::hits() const { return impl_->hits(); }
+
+unsigned long ConfigSourceCache::misses() const { return impl_->misses(); }
+
+}//namespace jet
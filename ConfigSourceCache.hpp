@@ -0,0 +1,42 @@
+//
+//  ConfigSourceCache.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_ConfigSourceCache_hpp
+#define JetConfig_ConfigSourceCache_hpp
+
+#include "ConfigSource.hpp"
+#include <boost/noncopyable.hpp>
+
+namespace jet
+{
+
+//...On-disk cache of parsed, normalized and validated config files. Entry of a file is used while
+//...the file has the same device, inode, modification time and size, so a hit costs a stat of the file.
+//...Content hash is compared too if the file was modified shortly before its entry was written, since
+//...then it could be changed again within resolution of timestamps. One cache directory can be shared
+//...by many processes. Cache is just an optimization: entry which can't be read or written is ignored
+//...and the file is parsed as usual.
+class ConfigSourceCache: boost::noncopyable
+{
+public:
+    explicit ConfigSourceCache(const std::string& directory);
+    ~ConfigSourceCache();
+    ConfigSource createFromFile(
+        const std::string& filename,
+        ConfigSource::Format format = ConfigSource::xml,
+        ConfigSource::FileNameStyle = ConfigSource::CaseSensitive,
+        ConfigSource::ParserMode = ConfigSource::DefaultParser);
+    unsigned long hits() const;
+    unsigned long misses() const;
+private:
+    class Impl;
+    boost::shared_ptr<Impl> impl_;
+};
+
+}//namespace jet
+
+#endif /*JetConfig_ConfigSourceCache_hpp*/
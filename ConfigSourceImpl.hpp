@@ -11,6 +11,7 @@
 
 #include "ConfigSource.hpp"
 #include <boost/property_tree/ptree.hpp>
+#include <boost/optional.hpp>
 
 #define ROOT_NODE_NAME     "config"
 #define SHARED_NODE_NAME   "shared"
@@ -28,16 +29,54 @@ public:
         std::istream& input,
         const std::string& name,
         ConfigSource::Format format,
-        ConfigSource::FileNameStyle fileNameStyle);
+        ConfigSource::FileNameStyle fileNameStyle,
+        ConfigSource::ParserMode parserMode,
+        const ConfigSource::Filter* filter = 0);
     Impl(
         const std::string& filename,
         ConfigSource::Format format,
-        ConfigSource::FileNameStyle fileNameStyle);
-    std::string toString(bool pretty) const;
+        ConfigSource::FileNameStyle fileNameStyle,
+        ConfigSource::ParserMode parserMode,
+        const ConfigSource::Filter* filter = 0);
+    Impl(
+        const char* begin,
+        const char* end,
+        const std::string& name,
+        ConfigSource::Format format,
+        ConfigSource::FileNameStyle fileNameStyle,
+        ConfigSource::ParserMode parserMode,
+        const ConfigSource::Filter* filter = 0);
+    Impl(const std::string& name, boost::property_tree::ptree& root);//...takes already normalized and validated tree
+    void write(std::ostream& os, bool pretty, ConfigSource::Format format) const;
     const std::string& name() const { return name_; }
+    const ConfigSource::Filter* filter() const { return filter_.get_ptr(); }
     const boost::property_tree::ptree& getRoot() const { return root_; }
+    boost::property_tree::ptree& getRoot() { return root_; }
 private:
-    void processRawTree(ConfigSource::FileNameStyle fileNameStyle);
+    class TreeBuilder;//...SAX-style sink that builds normalized tree while source is being tokenized
+    void readFile(
+        const std::string& filename,
+        ConfigSource::Format format,
+        ConfigSource::FileNameStyle fileNameStyle,
+        ConfigSource::ParserMode parserMode);
+    bool mapFile(
+        const std::string& filename,
+        ConfigSource::Format format,
+        ConfigSource::FileNameStyle fileNameStyle);
+    void readSource(
+        std::istream& input,
+        const std::string& fileName,
+        ConfigSource::Format format,
+        ConfigSource::FileNameStyle fileNameStyle);
+    void parseSource(
+        const char* begin,
+        const char* end,
+        const std::string& fileName,
+        ConfigSource::Format format,
+        ConfigSource::FileNameStyle fileNameStyle);
+    void normalizeRawTree(ConfigSource::FileNameStyle fileNameStyle);
+    void validate() const;
+    void throwEmptySourceError() const;
     void normalizeXmlAttributes(boost::property_tree::ptree& rawTree) const;
     void normalizeXmlAttributesImpl(
         const boost::property_tree::path& currentPath,
@@ -61,6 +100,7 @@ private:
     //...
     boost::property_tree::ptree root_;
     std::string name_;
+    boost::optional<ConfigSource::Filter> filter_;
 };
 
 }//namespace jet
@@ -0,0 +1,250 @@
+//
+//  ConfigSubscriptions.cpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#include "ConfigSubscriptions.hpp"
+#include <boost/algorithm/string.hpp>
+#include <boost/foreach.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace jet
+{
+
+namespace
+{
+
+typedef boost::optional<ConfigNodeView> OptionalView;
+typedef std::vector<size_t> Positions;
+//...positions of children with the same name in the previous node and in the current one
+typedef std::map<boost::string_ref, std::pair<Positions, Positions> > Occurrences;
+
+//...children with empty names or with '.' in names can't be found by path, so they aren't compared
+inline bool isKey(const boost::string_ref& name)
+{
+    return !name.empty() && boost::string_ref::npos == name.find('.');
+}
+
+inline ConfigChildren childrenOf(const OptionalView& node)
+{
+    return node ? node->children() : ConfigChildren();
+}
+
+inline OptionalView childAt(const ConfigChildren& children, const Positions& positions, size_t occurrence)
+{
+    return occurrence < positions.size() ? OptionalView(children.at(positions[occurrence])) : OptionalView();
+}
+
+//...then every occurrence of a name has the same position in both nodes
+bool isSameNames(const ConfigChildren& previous, const ConfigChildren& current)
+{
+    if(previous.size() != current.size())
+        return false;
+    for(size_t i = 0; i != current.size(); ++i)
+    {
+        if(previous.at(i).rawName() != current.at(i).rawName())
+            return false;
+    }
+    return true;
+}
+
+class Subscription: boost::noncopyable
+{
+public:
+    Subscription(ConfigSubscriptions::Id id, const std::string& path, const ConfigSubscriptions::Callback& callback):
+        id_(id),
+        callback_(callback)
+    {
+        boost::split(keys_, path, boost::is_any_of("."), boost::token_compress_on);
+        BOOST_FOREACH(std::string& key, keys_)
+            boost::trim(key);
+        keys_.erase(std::remove(keys_.begin(), keys_.end(), std::string()), keys_.end());
+    }
+    ConfigSubscriptions::Id id() const { return id_; }
+    void notify(const Config& previous, const Config& current) const
+    {
+        Diff diff(previous, current);
+        compare(diff, previous.view(), current.view(), 0);
+    }
+private:
+    //...state of one notification
+    struct Diff
+    {
+        Diff(const Config& previous, const Config& current): previous(previous), current(current) {}
+        const Config& previous;
+        const Config& current;
+        std::string path;//...of compared nodes
+        std::set<std::string> reported;//...repeated nodes have the same path, it's reported once
+    };
+    void compare(Diff& diff, const OptionalView& previousNode, const OptionalView& currentNode, size_t key) const
+    {
+        if(!previousNode && !currentNode)
+            return;
+        if(previousNode && currentNode && previousNode->contentHash() == currentNode->contentHash())
+            return;//...subtree is the same
+        if(keys_.size() == key)
+        {
+            if(diff.reported.insert(diff.path).second)
+                callback_(ConfigChange(diff.path, diff.previous, diff.current));
+            return;
+        }
+        const size_t pathSize = diff.path.size();
+        const boost::string_ref keyName(keys_[key]);
+        const bool isAnyName = "*" == keyName;
+        const ConfigChildren previousChildren(childrenOf(previousNode));
+        const ConfigChildren currentChildren(childrenOf(currentNode));
+        if(isSameNames(previousChildren, currentChildren))
+        {//...usually it's so, and only a few children are changed
+            for(size_t i = 0; i != currentChildren.size(); ++i)
+            {
+                const ConfigNodeView previousChild(previousChildren.at(i));
+                const ConfigNodeView currentChild(currentChildren.at(i));
+                const boost::string_ref name(currentChild.rawName());
+                if(previousChild.contentHash() != currentChild.contentHash() &&
+                    isKey(name) &&
+                    (isAnyName || keyName == name))
+                    compareChild(diff, previousChild, currentChild, name, key, pathSize);
+            }
+        }
+        else
+        {//...the k-th child with a name is compared with the k-th one, extra ones are added or removed
+            Occurrences occurrences;
+            for(size_t i = 0; i != previousChildren.size(); ++i)
+            {
+                const boost::string_ref name(previousChildren.at(i).rawName());
+                if(isKey(name) && (isAnyName || keyName == name))
+                    occurrences[name].first.push_back(i);
+            }
+            for(size_t i = 0; i != currentChildren.size(); ++i)
+            {
+                const boost::string_ref name(currentChildren.at(i).rawName());
+                if(isKey(name) && (isAnyName || keyName == name))
+                    occurrences[name].second.push_back(i);
+            }
+            BOOST_FOREACH(const Occurrences::value_type& positions, occurrences)
+            {
+                const size_t count = std::max(positions.second.first.size(), positions.second.second.size());
+                for(size_t occurrence = 0; occurrence != count; ++occurrence)
+                    compareChild(
+                        diff,
+                        childAt(previousChildren, positions.second.first, occurrence),
+                        childAt(currentChildren, positions.second.second, occurrence),
+                        positions.first,
+                        key,
+                        pathSize);
+            }
+        }
+        diff.path.resize(pathSize);
+    }
+    void compareChild(
+        Diff& diff,
+        const OptionalView& previousChild,
+        const OptionalView& currentChild,
+        const boost::string_ref& name,
+        size_t key,
+        size_t pathSize) const
+    {
+        diff.path.resize(pathSize);
+        if(pathSize)
+            diff.path += '.';
+        diff.path.append(name.data(), name.size());
+        compare(diff, previousChild, currentChild, key + 1);
+    }
+    //...
+    const ConfigSubscriptions::Id id_;
+    std::vector<std::string> keys_;
+    const ConfigSubscriptions::Callback callback_;
+};
+
+}//anonymous namespace
+
+class ConfigSubscriptions::Impl: boost::noncopyable
+{
+public:
+    Impl(): nextId_(1) {}
+    Id subscribe(const std::string& path, const Callback& callback)
+    {
+        const boost::lock_guard<boost::mutex> guard(mutex_);
+        subscriptions_.push_back(boost::shared_ptr<Subscription>(new Subscription(nextId_, path, callback)));
+        return nextId_++;
+    }
+    void unsubscribe(Id id)
+    {
+        const boost::lock_guard<boost::mutex> guard(mutex_);
+        for(std::vector<boost::shared_ptr<Subscription> >::iterator iter = subscriptions_.begin(); subscriptions_.end() != iter; ++iter)
+        {
+            if((*iter)->id() == id)
+            {
+                subscriptions_.erase(iter);
+                return;
+            }
+        }
+    }
+    void notify(const Config& previous, const Config& current) const
+    {
+        std::vector<boost::shared_ptr<Subscription> > subscriptions;
+        {//...callbacks are called without lock, so they can change subscriptions
+            const boost::lock_guard<boost::mutex> guard(mutex_);
+            subscriptions = subscriptions_;
+        }
+        for(size_t index = 0; index != subscriptions.size(); ++index)
+        {
+            try
+            {
+                subscriptions[index]->notify(previous, current);
+            }
+            catch(...)
+            {//...the rest of subscriptions are notified anyway, then the first exception is passed on
+                for(++index; index != subscriptions.size(); ++index)
+                {
+                    try
+                    {
+                        subscriptions[index]->notify(previous, current);
+                    }
+                    catch(...)
+                    {
+                    }
+                }
+                throw;
+            }
+        }
+    }
+private:
+    //...
+    mutable boost::mutex mutex_;
+    Id nextId_;
+    std::vector<boost::shared_ptr<Subscription> > subscriptions_;
+};
+
+ConfigSubscriptions::ConfigSubscriptions():
+    impl_(new Impl())
+{
+}
+
+ConfigSubscriptions::~ConfigSubscriptions()
+{
+}
+
+ConfigSubscriptions::Id ConfigSubscriptions::subscribe(const std::string& path, const Callback& callback)
+{
+    return impl_->subscribe(path, callback);
+}
+
+void ConfigSubscriptions::unsubscribe(Id id)
+{
+    impl_->unsubscribe(id);
+}
+
+void ConfigSubscriptions::notify(const Config& previous, const Config& current) const
+{
+    impl_->notify(previous, current);
+}
+
+}//namespace jet
@@ -0,0 +1,61 @@
+//
+//  ConfigSubscriptions.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_ConfigSubscriptions_hpp
+#define JetConfig_ConfigSubscriptions_hpp
+
+#include "Config.hpp"
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <string>
+
+namespace jet
+{
+
+//...node which is changed, added or removed in the current config, it is valid only during the callback
+struct ConfigChange
+{
+    ConfigChange(const std::string& path, const Config& previous, const Config& current):
+        path(path),
+        previous(previous),
+        current(current)
+    {}
+    const std::string& path;//...path of the node, e.g. 'routes.api' for subscription to 'routes.*'
+    const Config& previous;
+    const Config& current;
+};
+
+//...Callbacks subscribed to paths of config. When a new config replaces the previous one, only callbacks
+//...of changed paths are called. Paths are compared by content hashes of their subtrees, so an unchanged
+//...subtree is skipped at once, and only subtrees which differ are descended along the subscribed path.
+//...Path is '.' delimited, and key '*' matches every child of a node, e.g. 'database' or 'routes.*'. Every
+//...changed, added or removed node which matches the path is reported with its own ConfigChange. Children
+//...with the same name are compared by occurrence, the second 'route' with the second one, and extra ones
+//...are added or removed, repeated nodes have the same path, so it's reported once. Subscriptions can be
+//...changed from any thread, callbacks are called on the thread which calls notify().
+class ConfigSubscriptions: boost::noncopyable
+{
+public:
+    typedef boost::function<void(const ConfigChange&)> Callback;
+    typedef boost::uint64_t Id;
+    ConfigSubscriptions();
+    ~ConfigSubscriptions();
+    Id subscribe(const std::string& path, const Callback& callback);
+    void unsubscribe(Id id);
+    //...both configs must be locked. Exception of a callback stops only its own subscription, the other ones
+    //...are notified, and then the first exception is passed to the caller, the following ones are dropped
+    void notify(const Config& previous, const Config& current) const;
+private:
+    class Impl;
+    boost::shared_ptr<Impl> impl_;
+};
+
+}//namespace jet
+
+#endif /*JetConfig_ConfigSubscriptions_hpp*/
@@ -0,0 +1,271 @@
+//
+//  ConfigWriter.cpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+#include "ConfigWriter.hpp"
+#include <boost/property_tree/exceptions.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <ostream>
+
+namespace PT = boost::property_tree;
+typedef PT::ptree::value_type ValueType;
+typedef PT::ptree::const_assoc_iterator CAssocIter;
+typedef PT::ptree Tree;
+
+#define XML_ATTRIBUTES_NAME "<xmlattr>"
+#define XML_COMMENT_NAME    "<xmlcomment>"
+#define XML_TEXT_NAME       "<xmltext>"
+#define INDENT_SIZE 2
+
+namespace jet
+{
+
+namespace
+{
+
+inline void writeSpaces(std::ostream& os, size_t count)
+{
+    static const char spaces[] = "                                ";
+    for(; count > sizeof(spaces) - 1; count -= sizeof(spaces) - 1)
+        os.write(spaces, sizeof(spaces) - 1);
+    os.write(spaces, count);
+}
+
+}//anonymous namespace
+
+void XmlWriter::writeElement(const std::string& name, const Tree& tree, int indent)
+{//...the same steps as PT::xml_parser::write_xml_element does
+    bool hasElements = false;
+    bool hasAttributesOnly = tree.data().empty();
+    BOOST_FOREACH(const ValueType& child, tree)
+    {
+        if(XML_ATTRIBUTES_NAME != child.first)
+        {
+            hasAttributesOnly = false;
+            if(XML_TEXT_NAME != child.first)
+            {
+                hasElements = true;
+                break;
+            }
+        }
+    }
+    if(tree.data().empty() && tree.empty())
+    {
+        if(indent >= 0)
+        {
+            writeIndent(indent);
+            os_ << '<' << name << "/>";
+            if(pretty_)
+                os_ << '\n';
+        }
+        return;
+    }
+    if(indent >= 0)
+    {
+        writeIndent(indent);
+        os_ << '<' << name;
+        const CAssocIter attributes(tree.find(XML_ATTRIBUTES_NAME));
+        if(tree.not_found() != attributes)
+        {
+            BOOST_FOREACH(const ValueType& attribute, attributes->second)
+            {
+                os_ << ' ' << attribute.first << "=\"";
+                writeEncoded(attribute.second.data());
+                os_ << '"';
+            }
+        }
+        if(hasAttributesOnly)
+        {
+            os_ << "/>";
+            if(pretty_)
+                os_ << '\n';
+        }
+        else
+        {
+            os_ << '>';
+            if(hasElements && pretty_)
+                os_ << '\n';
+        }
+    }
+    if(!tree.data().empty())
+        writeText(tree.data(), indent + 1, hasElements && pretty_);
+    BOOST_FOREACH(const ValueType& child, tree)
+    {
+        if(XML_ATTRIBUTES_NAME == child.first)
+            continue;
+        else if(XML_COMMENT_NAME == child.first)
+            writeComment(child.second.data(), indent + 1);
+        else if(XML_TEXT_NAME == child.first)
+            writeText(child.second.data(), indent + 1, hasElements && pretty_);
+        else
+            writeElement(child.first, child.second, indent + 1);
+    }
+    if(indent >= 0 && !hasAttributesOnly)
+    {
+        if(hasElements)
+            writeIndent(indent);
+        os_ << "</" << name << '>';
+        if(pretty_)
+            os_ << '\n';
+    }
+}
+
+void XmlWriter::writeText(const std::string& text, int indent, bool isSeparateLine)
+{
+    if(isSeparateLine)
+        writeIndent(indent);
+    writeEncoded(text);
+    if(isSeparateLine)
+        os_ << '\n';
+}
+
+void XmlWriter::writeComment(const std::string& comment, int indent)
+{
+    if(pretty_)
+        writeIndent(indent);
+    os_ << "<!--" << comment << "-->";
+    if(pretty_)
+        os_ << '\n';
+}
+
+void XmlWriter::writeIndent(int indent)
+{
+    if(pretty_)
+        writeSpaces(os_, indent * INDENT_SIZE);
+}
+
+void XmlWriter::writeEncoded(const std::string& text)
+{
+    if(text.empty())
+        return;
+    if(std::string::npos == text.find_first_not_of(' '))
+    {//...text of spaces only is kept by encoding the first one
+        os_ << "&#32;";
+        writeSpaces(os_, text.size() - 1);
+        return;
+    }
+    const char* begin = text.data();
+    const char* const end = begin + text.size();
+    for(const char* iter = begin; end != iter; ++iter)
+    {
+        const char* entity;
+        switch(*iter)
+        {
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            case '&': entity = "&amp;"; break;
+            case '"': entity = "&quot;"; break;
+            case '\'': entity = "&apos;"; break;
+            default: continue;
+        }
+        os_.write(begin, iter - begin);
+        os_ << entity;
+        begin = iter + 1;
+    }
+    os_.write(begin, end - begin);
+}
+
+void JsonWriter::write(const Tree& tree)
+{
+    writeValue(tree, 0);
+    if(pretty_)
+        os_ << '\n';
+}
+
+void JsonWriter::writeValue(const Tree& tree, int indent)
+{//...the tree itself is always an object like in PT::write_json
+    if(indent > 0 && tree.empty())
+    {
+        writeString(tree.data());
+        return;
+    }
+    if(indent > 0 && !tree.data().empty())
+    {
+        throw PT::ptree_bad_data(
+            str(boost::format("Node '%1%' has both value and children, it can't be written as JSON") % path_),
+            tree.data());
+    }
+    os_ << '{';
+    for(Tree::const_iterator iter = tree.begin(); tree.end() != iter;)
+    {
+        Tree::const_iterator next(iter);
+        size_t count = 0;
+        for(; tree.end() != next && next->first == iter->first; ++next)
+            ++count;
+        if(tree.begin() != iter)
+            os_ << ',';
+        writeNewLine(indent + 1);
+        writeString(iter->first);
+        os_ << (pretty_ ? ": " : ":");
+        const size_t pathSize = path_.size();
+        if(pathSize)
+            path_ += '.';
+        path_ += iter->first;
+        if(1 == count)
+            writeValue(iter->second, indent + 1);
+        else
+        {//...adjacent nodes with the same name are an array, JsonReader reads it back as the same nodes
+            os_ << '[';
+            for(Tree::const_iterator element(iter); next != element; ++element)
+            {
+                if(iter != element)
+                    os_ << ',';
+                writeNewLine(indent + 2);
+                writeValue(element->second, indent + 2);
+            }
+            writeNewLine(indent + 1);
+            os_ << ']';
+        }
+        path_.resize(pathSize);
+        iter = next;
+    }
+    if(!tree.empty())
+        writeNewLine(indent);
+    os_ << '}';
+}
+
+void JsonWriter::writeString(const std::string& value)
+{
+    os_ << '"';
+    const char* begin = value.data();
+    const char* const end = begin + value.size();
+    for(const char* iter = begin; end != iter; ++iter)
+    {
+        const unsigned char ch = static_cast<unsigned char>(*iter);
+        if(ch >= 0x20 && '"' != ch && '\\' != ch)
+            continue;
+        os_.write(begin, iter - begin);
+        switch(ch)
+        {
+            case '"': os_ << "\\\""; break;
+            case '\\': os_ << "\\\\"; break;
+            case '\b': os_ << "\\b"; break;
+            case '\f': os_ << "\\f"; break;
+            case '\n': os_ << "\\n"; break;
+            case '\r': os_ << "\\r"; break;
+            case '\t': os_ << "\\t"; break;
+            default:
+            {
+                static const char digits[] = "0123456789abcdef";
+                const char escape[] = { '\\', 'u', '0', '0', digits[ch >> 4], digits[ch & 0xf] };
+                os_.write(escape, sizeof(escape));
+            }
+        }
+        begin = iter + 1;
+    }
+    os_.write(begin, end - begin);
+    os_ << '"';
+}
+
+void JsonWriter::writeNewLine(int indent)
+{
+    if(!pretty_)
+        return;
+    os_ << '\n';
+    writeSpaces(os_, indent * INDENT_SIZE);
+}
+
+}//namespace jet
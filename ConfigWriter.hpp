@@ -0,0 +1,58 @@
+//
+//  ConfigWriter.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_ConfigWriter_hpp
+#define JetConfig_ConfigWriter_hpp
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/noncopyable.hpp>
+#include <iosfwd>
+#include <string>
+
+namespace jet
+{
+
+//...Streaming XML writer. Output is exactly what PT::write_xml writes (with 2 spaces indentation if it's
+//...pretty), but without '<?xml ...?>' declaration, and it goes straight to the stream without any copies.
+//...Tree is a document, so its children are top level elements.
+class XmlWriter: boost::noncopyable
+{
+public:
+    XmlWriter(std::ostream& os, bool pretty): os_(os), pretty_(pretty) {}
+    void write(const boost::property_tree::ptree& tree) { writeElement(std::string(), tree, -1); }
+private:
+    void writeElement(const std::string& name, const boost::property_tree::ptree& tree, int indent);
+    void writeText(const std::string& text, int indent, bool isSeparateLine);
+    void writeComment(const std::string& comment, int indent);
+    void writeIndent(int indent);
+    void writeEncoded(const std::string& text);
+    //...
+    std::ostream& os_;
+    const bool pretty_;
+};
+
+//...Streaming JSON writer. Values are written as strings and adjacent nodes with the same name are written
+//...as an array, so JsonReader reads the same tree back. Node with both value and children can't be
+//...written, PT::ptree_bad_data is thrown for it. Data of the tree itself is ignored.
+class JsonWriter: boost::noncopyable
+{
+public:
+    JsonWriter(std::ostream& os, bool pretty): os_(os), pretty_(pretty) {}
+    void write(const boost::property_tree::ptree& tree);
+private:
+    void writeValue(const boost::property_tree::ptree& tree, int indent);
+    void writeString(const std::string& value);
+    void writeNewLine(int indent);
+    //...
+    std::ostream& os_;
+    const bool pretty_;
+    std::string path_;//...path of the node being written, it is used only in error messages
+};
+
+}//namespace jet
+
+#endif /*JetConfig_ConfigWriter_hpp*/
@@ -0,0 +1,350 @@
+//
+//  JsonReader.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_JsonReader_hpp
+#define JetConfig_JsonReader_hpp
+
+#include <boost/property_tree/detail/file_parser_error.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/config.hpp>
+#include <algorithm>
+#include <string>
+
+namespace jet
+{
+
+//...SAX-style JSON reader. It doesn't build any intermediate DOM, every node is reported to Handler:
+//...    bool startNode(const char* name, size_t size);//...false means the node must be skipped
+//...    void appendData(const char* data, size_t size);
+//...    void endNode();
+//...Members of an object become child nodes, scalars become node data and an array becomes a sequence
+//...of nodes with the same name (exactly like repeating XML elements). null is a node without data.
+template<class Handler>
+class JsonReader: boost::noncopyable
+{
+public:
+    JsonReader(
+        const char* begin,
+        const char* end,
+        const std::string& fileName,
+        Handler& handler):
+        begin_(begin), end_(end), pos_(begin), fileName_(fileName), handler_(handler), skipDepth_(0)
+    {}
+    void read()
+    {
+        if(end_ - pos_ >= 3 && //...skip UTF-8 BOM
+            '\xEF' == pos_[0] && '\xBB' == pos_[1] && '\xBF' == pos_[2])
+            pos_ += 3;
+        skipWhitespace();
+        if(end_ == pos_ || '{' != *pos_)
+            error("expected object");
+        readMembers();
+        skipWhitespace();
+        if(end_ != pos_)
+            error("garbage after data");
+    }
+private:
+    void readMembers()
+    {
+        ++pos_;//...skip '{'
+        skipWhitespace();
+        if(end_ != pos_ && '}' == *pos_)
+        {
+            ++pos_;
+            return;
+        }
+        std::string keyBuffer;
+        while(true)
+        {
+            skipWhitespace();
+            if(end_ == pos_ || '"' != *pos_)
+                error("expected key string");
+            const char* key;
+            size_t keySize;
+            readString(keyBuffer, key, keySize);
+            skipWhitespace();
+            if(end_ == pos_ || ':' != *pos_)
+                error("expected ':'");
+            ++pos_;
+            skipWhitespace();
+            readMemberValue(key, keySize);
+            skipWhitespace();
+            if(end_ == pos_)
+                error("unexpected end of data");
+            if(',' == *pos_)
+            {
+                ++pos_;
+                continue;
+            }
+            if('}' == *pos_)
+            {
+                ++pos_;
+                return;
+            }
+            error("expected ',' or '}'");
+        }
+    }
+    void readMemberValue(const char* key, size_t keySize)
+    {
+        if(end_ == pos_ || '[' != *pos_)
+        {
+            readNode(key, keySize);
+            return;
+        }
+        ++pos_;//...skip '['
+        skipWhitespace();
+        if(end_ != pos_ && ']' == *pos_)
+        {
+            ++pos_;
+            return;
+        }
+        while(true)
+        {
+            skipWhitespace();
+            if(end_ != pos_ && '[' == *pos_)
+                error("nested arrays are not supported");
+            readNode(key, keySize);
+            skipWhitespace();
+            if(end_ == pos_)
+                error("unexpected end of data");
+            if(',' == *pos_)
+            {
+                ++pos_;
+                continue;
+            }
+            if(']' == *pos_)
+            {
+                ++pos_;
+                return;
+            }
+            error("expected ',' or ']'");
+        }
+    }
+    void readNode(const char* name, size_t size)
+    {//...skipped node is still read to report syntax errors
+        if(skipDepth_ || !handler_.startNode(name, size))
+        {
+            ++skipDepth_;
+            readValue();
+            --skipDepth_;
+            return;
+        }
+        readValue();
+        handler_.endNode();
+    }
+    void readValue()
+    {
+        if(end_ == pos_)
+            error("unexpected end of data");
+        switch(*pos_)
+        {
+            case '{':
+                readMembers();
+                break;
+            case '"':
+            {
+                const char* data;
+                size_t size;
+                readString(valueBuffer_, data, size);
+                appendData(data, size);
+                break;
+            }
+            case 't':
+                readLiteral("true", 4);
+                appendData("true", 4);
+                break;
+            case 'f':
+                readLiteral("false", 5);
+                appendData("false", 5);
+                break;
+            case 'n':
+                readLiteral("null", 4);
+                break;
+            default:
+            {
+                const char* number = pos_;
+                readNumber();
+                appendData(number, pos_ - number);
+            }
+        }
+    }
+    void appendData(const char* data, size_t size)
+    {
+        if(!skipDepth_)
+            handler_.appendData(data, size);
+    }
+    void readLiteral(const char* literal, size_t size)
+    {
+        if(static_cast<size_t>(end_ - pos_) < size || !std::equal(literal, literal + size, pos_))
+            error("expected value");
+        pos_ += size;
+    }
+    void readNumber()
+    {
+        if(end_ != pos_ && '-' == *pos_)
+            ++pos_;
+        if(end_ == pos_ || !isDigit(*pos_))
+            error("expected value");
+        if('0' == *pos_)
+            ++pos_;
+        else
+            skipDigits();
+        if(end_ != pos_ && '.' == *pos_)
+        {
+            ++pos_;
+            if(end_ == pos_ || !isDigit(*pos_))
+                error("expected digits after '.'");
+            skipDigits();
+        }
+        if(end_ != pos_ && ('e' == *pos_ || 'E' == *pos_))
+        {
+            ++pos_;
+            if(end_ != pos_ && ('+' == *pos_ || '-' == *pos_))
+                ++pos_;
+            if(end_ == pos_ || !isDigit(*pos_))
+                error("expected digits in exponent");
+            skipDigits();
+        }
+    }
+    //...string without escape sequences is returned as a range of the input, otherwise it is decoded into buffer
+    void readString(std::string& buffer, const char*& data, size_t& size)
+    {
+        const char* const start = ++pos_;//...skip '"'
+        while(end_ != pos_ && '"' != *pos_ && '\\' != *pos_ && static_cast<unsigned char>(*pos_) >= 0x20)
+            ++pos_;
+        if(end_ != pos_ && '"' == *pos_)
+        {
+            data = start;
+            size = pos_ - start;
+            ++pos_;
+            return;
+        }
+        buffer.assign(start, pos_);
+        while(true)
+        {
+            if(end_ == pos_)
+                error("unterminated string");
+            const char ch = *pos_;
+            if('"' == ch)
+                break;
+            if(static_cast<unsigned char>(ch) < 0x20)
+                error("invalid character in string");
+            if('\\' != ch)
+            {
+                buffer += ch;
+                ++pos_;
+                continue;
+            }
+            if(end_ == ++pos_)
+                error("unterminated string");
+            switch(*pos_++)
+            {
+                case '"': buffer += '"'; break;
+                case '\\': buffer += '\\'; break;
+                case '/': buffer += '/'; break;
+                case 'b': buffer += '\b'; break;
+                case 'f': buffer += '\f'; break;
+                case 'n': buffer += '\n'; break;
+                case 'r': buffer += '\r'; break;
+                case 't': buffer += '\t'; break;
+                case 'u': appendCodePoint(buffer, readCodePoint()); break;
+                default: error("invalid escape sequence");
+            }
+        }
+        ++pos_;//...skip '"'
+        data = buffer.data();
+        size = buffer.size();
+    }
+    unsigned long readCodePoint()
+    {
+        unsigned long code = readHex4();
+        if(code >= 0xDC00 && code <= 0xDFFF)
+            error("invalid surrogate pair");
+        if(code >= 0xD800 && code <= 0xDBFF)
+        {
+            if(end_ - pos_ < 2 || '\\' != pos_[0] || 'u' != pos_[1])
+                error("invalid surrogate pair");
+            pos_ += 2;
+            const unsigned long low = readHex4();
+            if(low < 0xDC00 || low > 0xDFFF)
+                error("invalid surrogate pair");
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        return code;
+    }
+    unsigned long readHex4()
+    {
+        if(end_ - pos_ < 4)
+            error("invalid escape sequence");
+        unsigned long code = 0;
+        for(const char* last = pos_ + 4; last != pos_; ++pos_)
+        {
+            const char ch = *pos_;
+            code <<= 4;
+            if(ch >= '0' && ch <= '9')
+                code |= ch - '0';
+            else if(ch >= 'a' && ch <= 'f')
+                code |= ch - 'a' + 10;
+            else if(ch >= 'A' && ch <= 'F')
+                code |= ch - 'A' + 10;
+            else
+                error("invalid escape sequence");
+        }
+        return code;
+    }
+    static void appendCodePoint(std::string& buffer, unsigned long code)
+    {
+        if(code < 0x80)
+            buffer += static_cast<char>(code);
+        else if(code < 0x800)
+        {
+            buffer += static_cast<char>(0xC0 | (code >> 6));
+            buffer += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if(code < 0x10000)
+        {
+            buffer += static_cast<char>(0xE0 | (code >> 12));
+            buffer += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            buffer += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            buffer += static_cast<char>(0xF0 | (code >> 18));
+            buffer += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            buffer += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            buffer += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+    static bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
+    void skipDigits()
+    {
+        while(end_ != pos_ && isDigit(*pos_))
+            ++pos_;
+    }
+    void skipWhitespace()
+    {
+        while(end_ != pos_ && (' ' == *pos_ || '\n' == *pos_ || '\r' == *pos_ || '\t' == *pos_))
+            ++pos_;
+    }
+    BOOST_NORETURN void error(const char* message) const
+    {
+        const unsigned long line = static_cast<unsigned long>(std::count(begin_, pos_, '\n') + 1);
+        throw boost::property_tree::file_parser_error(message, fileName_, line);
+    }
+    //...
+    const char* const begin_;
+    const char* const end_;
+    const char* pos_;
+    const std::string& fileName_;
+    Handler& handler_;
+    std::string valueBuffer_;
+    size_t skipDepth_;//...depth inside of skipped node
+};
+
+}//namespace jet
+
+#endif /*JetConfig_JsonReader_hpp*/
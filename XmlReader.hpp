@@ -0,0 +1,443 @@
+//
+//  XmlReader.hpp
+//  JetConfig
+//
+//  This code belongs to public domain. You can do with it whatever you want without any guarantee.
+//
+
+#ifndef JetConfig_XmlReader_hpp
+#define JetConfig_XmlReader_hpp
+
+#include <boost/property_tree/detail/xml_parser_error.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/config.hpp>
+#include <algorithm>
+#include <string>
+
+namespace jet
+{
+
+//...SAX-style XML reader. It tokenizes source exactly like PT::read_xml with trim_whitespace flag does
+//...(the same whitespace trimming and condensing, entity expansion, comments as '<xmlcomment>' nodes,
+//...no validation of closing tags), but instead of building ptree it reports every node to Handler:
+//...    bool startNode(const char* name, size_t size);//...false means the node must be skipped
+//...    void attribute(const char* name, size_t nameSize, const char* value, size_t valueSize);
+//...    void endAttributes();
+//...    void appendData(const char* data, size_t size);
+//...    void endNode();
+//...Names are always ranges of the source, data is either range of the source or decoded copy.
+//...Skipped node is still tokenized to report syntax errors, but nothing of it is reported to Handler.
+template<class Handler>
+class XmlReader: boost::noncopyable
+{
+public:
+    XmlReader(
+        const char* begin,
+        const char* end,
+        const std::string& fileName,
+        Handler& handler):
+        begin_(begin), end_(end), pos_(begin), fileName_(fileName), handler_(handler), skipDepth_(0)
+    {}
+    void read()
+    {
+        if('\xEF' == at(0) && '\xBB' == at(1) && '\xBF' == at(2))//...skip UTF-8 BOM
+            pos_ += 3;
+        while(true)
+        {
+            skipWhitespace();
+            if('\0' == at())
+                break;
+            if('<' != *pos_)
+                error("expected <");
+            ++pos_;
+            readNode();
+        }
+    }
+private:
+    void readNode()
+    {
+        switch(at())
+        {
+            case '?'://...both xml declaration and processing instruction are skipped
+                ++pos_;
+                skipPast("?>");
+                return;
+            case '!':
+                if('-' == at(1) && '-' == at(2))
+                {
+                    pos_ += 3;
+                    readComment();
+                    return;
+                }
+                if(startsWith("![CDATA["))
+                {
+                    pos_ += 8;
+                    const char* data = pos_;
+                    skipTo("]]>");
+                    if(!skipDepth_)
+                        handler_.appendData(data, pos_ - data);
+                    pos_ += 3;
+                    return;
+                }
+                if(startsWith("!DOCTYPE") && isWhitespace(at(8)))
+                {
+                    pos_ += 9;
+                    skipDoctype();
+                    return;
+                }
+                ++pos_;//...skip other unrecognized nodes started with '<!'
+                while('>' != at())
+                {
+                    if('\0' == at())
+                        error("unexpected end of data");
+                    ++pos_;
+                }
+                ++pos_;
+                return;
+            default:
+                readElement();
+        }
+    }
+    void readComment()
+    {
+        const char* comment = pos_;
+        skipTo("-->");
+        if(!skipDepth_ && handler_.startNode("<xmlcomment>", sizeof("<xmlcomment>") - 1))
+        {
+            handler_.appendData(comment, pos_ - comment);
+            handler_.endNode();
+        }
+        pos_ += 3;
+    }
+    void skipDoctype()
+    {
+        while('>' != at())
+        {
+            switch(at())
+            {
+                case '[':
+                {
+                    ++pos_;
+                    for(int depth = 1; depth > 0; ++pos_)
+                    {
+                        switch(at())
+                        {
+                            case '[': ++depth; break;
+                            case ']': --depth; break;
+                            case '\0': error("unexpected end of data");
+                            default: break;
+                        }
+                    }
+                    break;
+                }
+                case '\0':
+                    error("unexpected end of data");
+                default:
+                    ++pos_;
+            }
+        }
+        ++pos_;
+    }
+    void readElement()
+    {
+        const char* name = pos_;
+        while(isNodeNameChar(at()))
+            ++pos_;
+        if(name == pos_)
+            error("expected element name");
+        const bool isSkipped = skipDepth_ || !handler_.startNode(name, pos_ - name);
+        if(isSkipped)
+            ++skipDepth_;
+        skipWhitespace();
+        readAttributes();
+        if(!skipDepth_)
+            handler_.endAttributes();
+        if('>' == at())
+        {
+            ++pos_;
+            readContents();
+        }
+        else if('/' == at())
+        {
+            ++pos_;
+            if('>' != at())
+                error("expected >");
+            ++pos_;
+        }
+        else
+            error("expected >");
+        if(isSkipped)
+            --skipDepth_;
+        else
+            handler_.endNode();
+    }
+    void readAttributes()
+    {
+        while(isAttributeNameChar(at()))
+        {
+            const char* name = pos_++;
+            while(isAttributeNameChar(at()))
+                ++pos_;
+            const size_t nameSize = pos_ - name;
+            skipWhitespace();
+            if('=' != at())
+                error("expected =");
+            ++pos_;
+            skipWhitespace();
+            const char quote = at();
+            if('\'' != quote && '"' != quote)
+                error("expected ' or \"");
+            ++pos_;
+            const char* value = pos_;
+            while(quote != at() && '&' != at() && '\0' != at())
+                ++pos_;
+            if('&' == at())
+            {//...slow path: expand entities
+                buffer_.assign(value, pos_);
+                while(quote != at() && '\0' != at())
+                {
+                    if('&' != *pos_ || !expandEntity(buffer_))
+                        buffer_ += *pos_++;
+                }
+                if(quote != at())
+                    error("expected ' or \"");
+                if(!skipDepth_)
+                    handler_.attribute(name, nameSize, buffer_.data(), buffer_.size());
+            }
+            else
+            {
+                if(quote != at())
+                    error("expected ' or \"");
+                if(!skipDepth_)
+                    handler_.attribute(name, nameSize, value, pos_ - value);
+            }
+            ++pos_;//...skip quote
+            skipWhitespace();
+        }
+    }
+    void readContents()
+    {
+        while(true)
+        {
+            skipWhitespace();
+            switch(at())
+            {
+                case '<':
+                    if('/' == at(1))
+                    {//...closing tag, its name is not validated
+                        pos_ += 2;
+                        while(isNodeNameChar(at()))
+                            ++pos_;
+                        skipWhitespace();
+                        if('>' != at())
+                            error("expected >");
+                        ++pos_;
+                        return;
+                    }
+                    ++pos_;
+                    readNode();
+                    break;
+                case '\0':
+                    error("unexpected end of data");
+                default:
+                    readData();
+            }
+        }
+    }
+    //...leading whitespace is already skipped, whitespace sequences are condensed to one space, trailing one is trimmed
+    void readData()
+    {
+        const char* data = pos_;
+        bool isPure = true;
+        for(char ch = at(); '<' != ch && '\0' != ch; ch = at())
+        {
+            if('&' == ch ||
+                ('\t' == ch || '\n' == ch || '\r' == ch) ||
+                (' ' == ch && isWhitespace(at(1))))
+            {
+                isPure = false;
+                break;
+            }
+            ++pos_;
+        }
+        if(isPure)
+        {
+            const char* end = pos_;
+            if(' ' == *(end - 1))
+                --end;
+            if(!skipDepth_)
+                handler_.appendData(data, end - data);
+            return;
+        }
+        buffer_.assign(data, pos_);
+        for(char ch = at(); '<' != ch && '\0' != ch; ch = at())
+        {
+            if('&' == ch && expandEntity(buffer_))
+                continue;
+            if(isWhitespace(ch))
+            {
+                buffer_ += ' ';
+                while(isWhitespace(at()))
+                    ++pos_;
+                continue;
+            }
+            buffer_ += ch;
+            ++pos_;
+        }
+        if(!buffer_.empty() && ' ' == buffer_[buffer_.size() - 1])
+            buffer_.resize(buffer_.size() - 1);
+        if(!skipDepth_)
+            handler_.appendData(buffer_.data(), buffer_.size());
+    }
+    //...returns false if there is no known entity at current position, so '&' must be copied verbatim
+    bool expandEntity(std::string& out)
+    {
+        switch(at(1))
+        {
+            case 'a':
+                if(startsWith("&amp;"))
+                {
+                    out += '&';
+                    pos_ += 5;
+                    return true;
+                }
+                if(startsWith("&apos;"))
+                {
+                    out += '\'';
+                    pos_ += 6;
+                    return true;
+                }
+                return false;
+            case 'q':
+                if(!startsWith("&quot;"))
+                    return false;
+                out += '"';
+                pos_ += 6;
+                return true;
+            case 'g':
+                if(!startsWith("&gt;"))
+                    return false;
+                out += '>';
+                pos_ += 4;
+                return true;
+            case 'l':
+                if(!startsWith("&lt;"))
+                    return false;
+                out += '<';
+                pos_ += 4;
+                return true;
+            case '#':
+            {
+                const unsigned long base = 'x' == at(2) ? 16 : 10;
+                pos_ += 16 == base ? 3 : 2;
+                unsigned long code = 0;
+                for(int digit = hexDigit(at()); digit >= 0; digit = hexDigit(at()))
+                {//...exactly like read_xml, hexadecimal digits are accepted in decimal references too
+                    code = code * base + digit;
+                    ++pos_;
+                }
+                appendCodedCharacter(out, code);
+                if(';' != at())
+                    error("expected ;");
+                ++pos_;
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+    void appendCodedCharacter(std::string& out, unsigned long code) const
+    {
+        if(code < 0x80)
+            out += static_cast<char>(code);
+        else if(code < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if(code < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if(code < 0x110000)
+        {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+            error("invalid numeric character entity");
+    }
+    void skipTo(const char* terminator)
+    {
+        while(!startsWith(terminator))
+        {
+            if('\0' == at())
+                error("unexpected end of data");
+            ++pos_;
+        }
+    }
+    void skipPast(const char* terminator)
+    {
+        skipTo(terminator);
+        pos_ += std::char_traits<char>::length(terminator);
+    }
+    bool startsWith(const char* prefix) const
+    {
+        for(size_t i = 0; '\0' != prefix[i]; ++i)
+        {
+            if(prefix[i] != at(i))
+                return false;
+        }
+        return true;
+    }
+    //...end of the source looks like zero terminator, the same way as for read_xml
+    char at(size_t offset = 0) const
+    {
+        return static_cast<size_t>(end_ - pos_) > offset ? pos_[offset] : '\0';
+    }
+    void skipWhitespace()
+    {
+        while(pos_ != end_ && isWhitespace(*pos_))
+            ++pos_;
+    }
+    static bool isWhitespace(char ch) { return ' ' == ch || '\n' == ch || '\r' == ch || '\t' == ch; }
+    static bool isNodeNameChar(char ch)
+    {
+        return !isWhitespace(ch) && '/' != ch && '>' != ch && '?' != ch && '\0' != ch;
+    }
+    static bool isAttributeNameChar(char ch)
+    {
+        return isNodeNameChar(ch) && '<' != ch && '=' != ch && '!' != ch;
+    }
+    static int hexDigit(char ch)
+    {
+        if(ch >= '0' && ch <= '9')
+            return ch - '0';
+        if(ch >= 'a' && ch <= 'f')
+            return ch - 'a' + 10;
+        if(ch >= 'A' && ch <= 'F')
+            return ch - 'A' + 10;
+        return -1;
+    }
+    BOOST_NORETURN void error(const char* message) const
+    {
+        const unsigned long line = static_cast<unsigned long>(std::count(begin_, pos_, '\n') + 1);
+        throw boost::property_tree::xml_parser::xml_parser_error(message, fileName_, line);
+    }
+    //...
+    const char* const begin_;
+    const char* const end_;
+    const char* pos_;
+    const std::string& fileName_;
+    Handler& handler_;
+    std::string buffer_;
+    size_t skipDepth_;//...depth inside of skipped node
+};
+
+}//namespace jet
+
+#endif /*JetConfig_XmlReader_hpp*/
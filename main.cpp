@@ -7,12 +7,31 @@
 //
 #include "gtest.hpp"
 #include "Config.hpp"
+#include "ConfigBinding.hpp"
 #include "ConfigError.hpp"
+#include "ConfigImage.hpp"
+#include "ConfigReloader.hpp"
+#include "ConfigSnapshots.hpp"
+#include "ConfigSourceCache.hpp"
+#include "ConfigSubscriptions.hpp"
+#include <boost/bind/bind.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/move/utility_core.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
 
 using std::cout;
 using std::endl;
+using namespace boost::placeholders;
 
 TEST(ConfigSource, SimpleConfigSource)
 {
@@ -346,6 +365,282 @@ TEST(ConfigSource, ProhibitedInstanceSubsectionInSharedSection)
         "Config source 's1.xml' is invalid: 'shared' node can not contain 'Instance' node");
 }
 
+TEST(ConfigSource, SimpleJsonConfigSource)
+{
+    const jet::ConfigSource source(
+        "{ \"app\": { \"str\": \"value\", \"int\": 10, \"flag\": true, \"none\": null } }",
+        "s1.json",
+        jet::ConfigSource::json);
+    EXPECT_EQ(
+        "<config><app><str>value</str><int>10</int><flag>true</flag><none/></app></config>",
+        source.toString(jet::ConfigSource::OneLine));
+    EXPECT_EQ(
+        "<config><app><str>a&quot;b\\c\xC3\xA9\xF0\x9F\x98\x80</str></app></config>",
+        jet::ConfigSource(
+            "{\"config\": {\"app\": {\"str\": \"a\\\"b\\\\c\\u00e9\\ud83d\\ude00\"}}}",
+            "s1.json",
+            jet::ConfigSource::json).toString(jet::ConfigSource::OneLine));
+}
+
+TEST(ConfigSource, NormalizeJsonConfigSource)
+{
+    const jet::ConfigSource xmlSource(
+        "<config>"
+        "   <Shared><lib attr='1'/></Shared>"
+        "   <app:i1 attr='value'/>"
+        "   <APP2><Instance><i2 attr='value2'/></Instance></APP2>"
+        "   <app str='value3'/>"
+        "</config>",
+        "s1.xml",
+        jet::ConfigSource::xml,
+        jet::ConfigSource::CaseInsensitive);
+    const jet::ConfigSource jsonSource(
+        "{\n"
+        "  \"Shared\": { \"lib\": { \"attr\": 1 } },\n"
+        "  \"app:i1\": { \"attr\": \"value\" },\n"
+        "  \"APP2\": { \"Instance\": { \"i2\": { \"attr\": \"value2\" } } },\n"
+        "  \"app\": { \"str\": \"value3\" }\n"
+        "}\n",
+        "s1.json",
+        jet::ConfigSource::json,
+        jet::ConfigSource::CaseInsensitive);
+    EXPECT_EQ(xmlSource.toString(), jsonSource.toString());
+}
+
+TEST(ConfigSource, JsonArrayConfigSource)
+{
+    const jet::ConfigSource source(
+        "{\"deployment\": {\"box\": [{\"hostname\": \"UK1\"}, {\"hostname\": \"UK2\"}], \"ports\": [10, 20], \"empty\": []}}",
+        "s1.json",
+        jet::ConfigSource::json);
+    EXPECT_EQ(
+        "<config><deployment>"
+        "<box><hostname>UK1</hostname></box>"
+        "<box><hostname>UK2</hostname></box>"
+        "<ports>10</ports><ports>20</ports>"
+        "</deployment></config>",
+        source.toString(jet::ConfigSource::OneLine));
+}
+
+TEST(ConfigSource, InvalidJsonConfigSource)
+{
+    CONFIG_ERROR(jet::ConfigSource("{}", "s1.json", jet::ConfigSource::json),
+        "Couldn't parse config 's1.json'. Reason:");
+    CONFIG_ERROR(jet::ConfigSource("[]", "s1.json", jet::ConfigSource::json),
+        "Couldn't parse config 's1.json'. Reason: <unspecified file>(1): expected object");
+    CONFIG_ERROR(jet::ConfigSource("{\"app\": {\"attr\": 1}} x", "s1.json", jet::ConfigSource::json),
+        "Couldn't parse config 's1.json'. Reason: <unspecified file>(1): garbage after data");
+    CONFIG_ERROR(jet::ConfigSource("{\"app\":\n{\"attr\": 01}}", "s1.json", jet::ConfigSource::json),
+        "Couldn't parse config 's1.json'. Reason: <unspecified file>(2): expected ',' or '}'");
+    CONFIG_ERROR(jet::ConfigSource("{\"app\": {\"attr\": [[1]]}}", "s1.json", jet::ConfigSource::json),
+        "Couldn't parse config 's1.json'. Reason: <unspecified file>(1): nested arrays are not supported");
+    CONFIG_ERROR(jet::ConfigSource("{\"app\": \"data\"}", "s1.json", jet::ConfigSource::json),
+        "Invalid data node 'data' under 'app' node in config source 's1.json'");
+    CONFIG_ERROR(jet::ConfigSource("{\"app\": {}, \"config\": {}}", "s1.json", jet::ConfigSource::json),
+        "Invalid config source 's1.json'. 'config' must be root node");
+    CONFIG_ERROR(
+        jet::ConfigSource(
+            "{\"app\": {\"instance\": {\"i1\": {}}}, \"app:i1\": {\"attr\": 1}}",
+            "s1.json",
+            jet::ConfigSource::json),
+        "Duplicate node 'app:i1' in config source 's1.json'");
+}
+
+namespace
+{
+std::string parseToString(
+    const std::string& source,
+    jet::ConfigSource::ParserMode parserMode,
+    jet::ConfigSource::FileNameStyle fileNameStyle = jet::ConfigSource::CaseSensitive)
+{
+    try
+    {
+        return jet::ConfigSource(source, "s1.xml", jet::ConfigSource::xml, fileNameStyle, parserMode).toString();
+    }
+    catch(const jet::ConfigError& ex)
+    {
+        return std::string("error: ") + ex.what();
+    }
+}
+}//anonymous namespace
+
+TEST(ConfigSource, SinglePassParser)
+{
+    const char* sources[] = {
+        "<app> <attr> value</attr></app> ",
+        "<?xml version='1.0'?><!DOCTYPE config [ <!ELEMENT config ANY> ]><Config><app attr=' a &amp; b '/></Config>",
+        "<config><app><attr>  multi \n\t line  <![CDATA[ cdata ]]> text &#65;&#x42;&lt;&gt;</attr></app></config>",
+        "<config><!-- comment --><app:i1 attr='value'/></config>",
+        "<config><app attr='value' attr1='value1'/><app:i2 attr1='value11' attr2='value2'/></config>",
+        "<config><app:i2 attr1='value11'/><app attr='value'/><app:i1 attr='1'/></config>",
+        "<app attr1='value1' attr2=\"value2\"><attr3 attr4='value4'><attr5>value5</attr5></attr3></app>",
+        "<APP><Instance><i1/></Instance></APP><Shared><lib x='1'/></Shared>",
+        "<app><key attr='1'><attr>2</attr></key></app>",
+        "<config attr='value1' attr='value2'></config>",
+        "<app><env attr='value1'>data</env></app>",
+        "<config><app:i1><env PATH='/usr/bin'/></app:i1><app:i1/></config>",
+        "<config><shared:i1><env PATH='/usr/bin'/></shared></config:i1>",
+        "<app/><config/>",
+        "<!-- comment --><config/>",
+        "<config><app: attr='value'/></config>",
+        "<config><app attr='1'/></config",
+        "  ",
+    };
+    BOOST_FOREACH(const char* source, sources)
+    {
+        EXPECT_EQ(
+            parseToString(source, jet::ConfigSource::DefaultParser),
+            parseToString(source, jet::ConfigSource::SinglePassParser)) << source;
+        EXPECT_EQ(
+            parseToString(source, jet::ConfigSource::DefaultParser, jet::ConfigSource::CaseInsensitive),
+            parseToString(source, jet::ConfigSource::SinglePassParser, jet::ConfigSource::CaseInsensitive)) << source;
+    }
+}
+
+namespace
+{
+//...files of tests are in the temporary directory, with unique names, so tests can run at the same time
+boost::filesystem::path temporaryPath(const std::string& model)
+{
+    return boost::filesystem::temp_directory_path() / boost::filesystem::unique_path(model);
+}
+
+std::string parseFileToString(const std::string& filename, jet::ConfigSource::ParserMode parserMode)
+{
+    try
+    {
+        return jet::ConfigSource::createFromFile(
+            filename, jet::ConfigSource::xml, jet::ConfigSource::CaseSensitive, parserMode).toString();
+    }
+    catch(const jet::ConfigError& ex)
+    {
+        return std::string("error: ") + ex.what();
+    }
+}
+}//anonymous namespace
+
+TEST(ConfigSource, MappedFileParser)
+{
+    const char* sources[] = {
+        "<config><app attr='a &amp; b'><key> value </key></app><app:i1 attr='1'/></config>",
+        "<config><app attr='1'/></config",
+        "",
+    };
+    const std::string filename(temporaryPath("JetConfigMappedFileParserTest-%%%%-%%%%-%%%%.xml").string());
+    BOOST_FOREACH(const char* source, sources)
+    {
+        std::ofstream(filename.c_str()) << source;
+        EXPECT_EQ(
+            parseFileToString(filename, jet::ConfigSource::DefaultParser),
+            parseFileToString(filename, jet::ConfigSource::MappedFileParser)) << source;
+    }
+    std::remove(filename.c_str());
+    EXPECT_EQ(
+        parseFileToString(filename, jet::ConfigSource::DefaultParser),
+        parseFileToString(filename, jet::ConfigSource::MappedFileParser));
+}
+
+TEST(ConfigSource, Buffer)
+{
+    const std::string source("<config><app attr='a &amp; b'><key> value </key></app><app:i1 attr='1'/></config>");
+    const std::string buffer(source + "<garbage after the end of buffer");
+    const jet::ConfigSource::ParserMode modes[] = {
+        jet::ConfigSource::DefaultParser,
+        jet::ConfigSource::SinglePassParser,
+    };
+    BOOST_FOREACH(jet::ConfigSource::ParserMode mode, modes)
+    {
+        EXPECT_EQ(
+            jet::ConfigSource(buffer.data(), source.size(), "buffer.xml", jet::ConfigSource::xml,
+                jet::ConfigSource::CaseSensitive, mode).toString(),
+            jet::ConfigSource(source).toString()) << mode;
+    }
+    EXPECT_EQ(
+        jet::ConfigSource(buffer.data(), source.size(), jet::ConfigSource::Filter("app")).toString(),
+        jet::ConfigSource("<config><app attr='a &amp; b'><key> value </key></app></config>").toString());
+    CONFIG_ERROR(
+        jet::ConfigSource(buffer.data(), buffer.size(), "buffer.xml"),
+        "Couldn't parse config 'buffer.xml'. Reason: <unspecified file>(1): expected =");
+}
+
+TEST(ConfigSource, JsonOutput)
+{
+    const jet::ConfigSource source(
+        "<app attr='a \"b\"'><key>1</key><key>2</key><sub/></app><shared><lib path='c:\\lib'/></shared>");
+    const std::string json(source.toString(jet::ConfigSource::OneLine, jet::ConfigSource::json));
+    EXPECT_EQ(
+        json,
+        "{\"config\":{\"app\":{\"attr\":\"a \\\"b\\\"\",\"key\":[\"1\",\"2\"],\"sub\":\"\"},"
+        "\"shared\":{\"lib\":{\"path\":\"c:\\\\lib\"}}}}");
+    EXPECT_EQ(
+        jet::ConfigSource(json, "source.json", jet::ConfigSource::json).toString(),
+        source.toString());
+    std::ostringstream strm;
+    source.write(strm, jet::ConfigSource::Pretty, jet::ConfigSource::json);
+    EXPECT_EQ(
+        jet::ConfigSource(strm.str(), "source.json", jet::ConfigSource::json).toString(),
+        source.toString());
+}
+
+TEST(ConfigSource, ParseCache)
+{
+    namespace FS = boost::filesystem;
+    const FS::path directory(temporaryPath("JetConfigParseCacheTest-%%%%-%%%%-%%%%.d"));
+    FS::create_directory(directory);
+    const std::string filename((directory / "app.xml").string());
+    std::ofstream(filename.c_str()) << "<app attr='1'><key>a</key><key>b</key></app>";
+    jet::ConfigSourceCache cache(directory.string());
+    const std::string expected(jet::ConfigSource::createFromFile(filename).toString());
+    EXPECT_EQ(cache.createFromFile(filename).toString(), expected);
+    EXPECT_EQ(cache.hits(), 0);
+    EXPECT_EQ(cache.misses(), 1);
+    const jet::ConfigSource cached(cache.createFromFile(filename));
+    EXPECT_EQ(cached.toString(), expected);
+    EXPECT_EQ(cached.name(), filename);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.misses(), 1);
+    EXPECT_EQ(jet::ConfigSourceCache(directory.string()).createFromFile(filename).toString(), expected);
+
+    jet::Config config("app");
+    config << cached << jet::lock;
+    EXPECT_EQ(config.get("key"), "a");
+
+    std::ofstream(filename.c_str()) << "<app attr='2'><key>a</key><key>b</key></app>";
+    EXPECT_EQ(cache.createFromFile(filename).toString(), jet::ConfigSource::createFromFile(filename).toString());
+    EXPECT_EQ(cache.misses(), 2);
+    std::ofstream(filename.c_str()) << "<app attr='1'/><config/>";
+    CONFIG_ERROR(cache.createFromFile(filename), "Invalid config source '" + filename + "'. 'config' must be root node");
+    EXPECT_EQ(cache.misses(), 3);
+    {//...file which is changed without change of its stat is found out by content, while its entry is recent
+        const std::time_t modificationTime = std::time(0);
+        std::ofstream(filename.c_str()) << "<app attr='3'/>";
+        FS::last_write_time(filename, modificationTime);
+        EXPECT_EQ(cache.createFromFile(filename).toString(), jet::ConfigSource::createFromFile(filename).toString());
+        std::ofstream(filename.c_str()) << "<app attr='4'/>";
+        FS::last_write_time(filename, modificationTime);
+        EXPECT_EQ(cache.createFromFile(filename).toString(), jet::ConfigSource::createFromFile(filename).toString());
+        EXPECT_EQ(cache.misses(), 5);
+        EXPECT_EQ(cache.createFromFile(filename).toString(), jet::ConfigSource::createFromFile(filename).toString());
+        EXPECT_EQ(cache.hits(), 2);
+    }
+    {//...entry which can't be renamed into place doesn't leave its temporary file behind
+        std::vector<FS::path> entries;
+        for(FS::directory_iterator iter(directory); FS::directory_iterator() != iter; ++iter)
+        {
+            if(".cache" == iter->path().extension())
+                entries.push_back(iter->path());
+        }
+        ASSERT_EQ(entries.size(), 1u);
+        FS::remove(entries.front());
+        FS::create_directories(entries.front() / "busy");
+        std::ofstream(filename.c_str()) << "<app attr='5'/>";
+        EXPECT_EQ(cache.createFromFile(filename).toString(), jet::ConfigSource::createFromFile(filename).toString());
+        for(FS::directory_iterator iter(directory); FS::directory_iterator() != iter; ++iter)
+            EXPECT_NE(iter->path().extension(), ".tmp");
+    }
+    FS::remove_all(directory);
+}
+
 TEST(Config, SharedAttrConfigWithoutRootConfigElement)
 {
     const jet::ConfigSource shared(
@@ -488,8 +783,7 @@ TEST(Config, Initialization)
     
     {//...check config before locking it
         const char* unlockedConfig =
-"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n\
-<config>\n\
+"<config>\n\
   <1>\n\
     <lib>\n\
       <attr1>0s1</attr1>\n\
@@ -732,6 +1026,929 @@ TEST(Config, repeatingNodeMergeWithConflicts2)
     CONFIG_ERROR(config << s2, "Can't do ambiguous merge of node 'key' from config source 's2' to config 'app'");
 }
 
+TEST(Config, Snapshot)
+{
+    const jet::ConfigSource s1(
+"<config>\n\
+    <shared>\n\
+        <db host='localhost' port='5432'/>\n\
+    </shared>\n\
+    <app timeout='10'>\n\
+        <key attr='1'/>\n\
+        <key attr='2'/>\n\
+        <db port='6432'/>\n\
+    </app>\n\
+    <app:i1 timeout='20'/>\n\
+</config>\n",
+        "s1");
+    const boost::filesystem::path snapshot(temporaryPath("JetConfigSnapshotTest-%%%%-%%%%-%%%%.bin"));
+    const std::string filename(snapshot.string());
+    jet::Config config("app", "i1");
+    config << s1 << jet::lock;
+    config.saveSnapshot(filename);
+
+    jet::Config loaded("app", "i1");
+    loaded.loadSnapshot(filename);
+    EXPECT_EQ(loaded.get<int>("timeout"), 20);
+    EXPECT_EQ(loaded.get("db.host"), "localhost");
+    EXPECT_EQ(loaded.get<int>("db.port"), 6432);
+    EXPECT_EQ(loaded.get("key.attr"), "1");
+    EXPECT_EQ(loaded.getNode("db").get("port"), "6432");
+    EXPECT_EQ(loaded.getNode("db").name(), "app:i1.db");
+    EXPECT_FALSE(loaded.getOptional("missing"));
+    EXPECT_EQ(loaded.getChildrenOf().size(), config.getChildrenOf().size());
+    EXPECT_EQ(loaded.getChildrenOf("key").size(), 1);
+    CONFIG_ERROR(loaded.get("db"), "Node 'app:i1.db' is intermidiate node without value");
+    EXPECT_ANY_THROW(loaded.getChildrenOf("missing"));
+    std::stringstream expected, actual;
+    expected << config;
+    actual << loaded;
+    EXPECT_EQ(expected.str(), actual.str());
+
+    loaded.saveSnapshot(filename);//...snapshot of loaded config is the same
+    jet::Config reloaded("app", "i1");
+    reloaded.loadSnapshot(filename);
+    EXPECT_EQ(reloaded.get<int>("timeout"), 20);
+    {//...concurrent saves use their own temporary files and leave none of them
+        namespace FS = boost::filesystem;
+        boost::thread_group savers;
+        for(size_t i = 0; i != 4; ++i)
+            savers.create_thread(boost::bind(&jet::Config::saveSnapshot, boost::cref(config), filename));
+        savers.join_all();
+        jet::Config saved("app", "i1");
+        saved.loadSnapshot(filename);
+        EXPECT_EQ(saved.get<int>("timeout"), 20);
+        for(FS::directory_iterator iter(snapshot.parent_path()); FS::directory_iterator() != iter; ++iter)
+            EXPECT_NE(iter->path().filename().string().find(snapshot.filename().string() + "."), 0u);
+    }
+
+    CONFIG_ERROR(loaded.loadSnapshot(filename), "Config 'app:i1' is locked");
+    jet::Config other("app");
+    CONFIG_ERROR(other.loadSnapshot(filename),
+        "Config snapshot '" + filename + "' is created for config 'app:i1', not for 'app'");
+    {//...corrupt one byte
+        std::fstream file(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('?');
+    }
+    CONFIG_ERROR(other.loadSnapshot(filename),
+        "Couldn't load config snapshot '" + filename + "'. Reason: checksum mismatch");
+    std::remove(filename.c_str());
+    CONFIG_ERROR(other.loadSnapshot(filename),
+        "Couldn't load config snapshot '" + filename + "'. Reason: cannot open file");
+    CONFIG_ERROR(jet::Config("app").saveSnapshot(filename), "Initialization of config 'app' is not finished");
+}
+
+TEST(Config, DirectoryConfigSourceMerge)
+{
+    namespace FS = boost::filesystem;
+    const FS::path directory(temporaryPath("JetConfigDirectoryTest-%%%%-%%%%-%%%%.d"));
+    FS::create_directory(directory);
+    std::ofstream((directory / "20-override.xml").string().c_str()) << "<app attr='2'/>";
+    std::ofstream((directory / "10-base.xml").string().c_str()) << "<app attr='1' other='1'/>";
+    std::ofstream((directory / "15-ignored.json").string().c_str()) << "{\"app\": {\"attr\": 3}}";
+    std::ofstream((directory / "README").string().c_str()) << "not a config";
+    {
+        const jet::ConfigSources sources(jet::ConfigSource::createFromDirectory(directory.string()));
+        ASSERT_EQ(sources.size(), 2);
+        EXPECT_EQ(sources[0].name(), (directory / "10-base.xml").string());
+        EXPECT_EQ(sources[1].name(), (directory / "20-override.xml").string());
+        jet::Config config("app");
+        config << sources << jet::lock;
+        EXPECT_EQ(config.get<int>("attr"), 2);
+        EXPECT_EQ(config.get<int>("other"), 1);
+    }
+    std::ofstream((directory / "30-invalid.xml").string().c_str()) << "<app attr='1'/><config/>";
+    std::ofstream((directory / "40-invalid.xml").string().c_str()) << "<app";
+    CONFIG_ERROR(
+        jet::ConfigSource::createFromDirectory(directory.string()),
+        "Invalid config source '" + (directory / "30-invalid.xml").string() + "'. 'config' must be root node");
+    FS::remove_all(directory);
+    CONFIG_ERROR(
+        jet::ConfigSource::createFromFiles(std::vector<std::string>(1, (directory / "10-base.xml").string())),
+        "Couldn't parse config '" + (directory / "10-base.xml").string() + "'. Reason: " +
+        (directory / "10-base.xml").string() + ": cannot open file");
+}
+
+TEST(Config, JsonConfigSourceMerge)
+{
+    const jet::ConfigSource s1("<appName attr1='10' attr2='something'><sub attr='1'/></appName>", "s1.xml");
+    const jet::ConfigSource s2(
+        "{\"appName:1\": {\"attr2\": 20, \"sub\": {\"attr\": \"2\"}}, \"shared\": {\"lib\": {\"attr\": 3.5}}}",
+        "s2.json",
+        jet::ConfigSource::json);
+    jet::Config config("appName", "1");
+    config << s1 << s2 << jet::lock;
+    EXPECT_EQ(10,  config.get<int>("attr1"));
+    EXPECT_EQ(20,  config.get<int>("attr2"));
+    EXPECT_EQ(2,   config.get<int>("sub.attr"));
+    EXPECT_EQ(3.5, config.get<double>("lib.attr"));
+}
+
+TEST(Config, MovedConfigSourceMerge)
+{
+    const char* base = "<app attr='1'><sub attr='1'/><list><item/></list></app><app:i1 attr='2'/><shared><lib attr='3'/></shared>";
+    const char* override = "<app><sub attr='2' other='2'/><new><key>value</key></new></app>";
+    jet::Config copied("app", "i1");
+    const jet::ConfigSource baseSource(base, "base.xml");
+    const jet::ConfigSource overrideSource(override, "override.xml");
+    copied << baseSource << overrideSource << jet::lock;
+    jet::Config moved("app", "i1");
+    jet::ConfigSource movedBase(base, "base.xml");
+    jet::ConfigSource movedOverride(override, "override.xml");
+    const jet::ConfigSource sharedOverride(movedOverride);
+    moved << boost::move(movedBase) << boost::move(movedOverride) << jet::lock;
+    std::ostringstream copiedOutput;
+    copiedOutput << copied;
+    std::ostringstream movedOutput;
+    movedOutput << moved;
+    EXPECT_EQ(copiedOutput.str(), movedOutput.str());
+    EXPECT_EQ(movedBase.toString(jet::ConfigSource::OneLine), "<config/>");
+    EXPECT_EQ(movedBase.name(), "base.xml");
+    EXPECT_EQ(movedOverride.toString(), overrideSource.toString());//...it's shared with the other handle
+    jet::Config ambiguous("app");
+    ambiguous << jet::ConfigSource("<app><key/><key/></app>", "s1.xml");
+    jet::ConfigSource ambiguousSource("<app><key/></app>", "s2.xml");
+    CONFIG_ERROR(
+        ambiguous << boost::move(ambiguousSource),
+        "Can't do ambiguous merge of node 'key' from config source 's2.xml' to config 'app'");
+}
+
+TEST(Config, FilteredConfigSourceMerge)
+{
+    const std::string source(
+        "<config>"
+        "<other attr='1'><key>1</key><key>2</key></other>"
+        "<App attr='1'><instance><i1 attr='2'/><i2 attr='3'/></instance><sub attr='a &amp; b'/></App>"
+        "<other:i1 attr='1' attr='2'/>"
+        "<app:i3 extra='4'/>"
+        "<shared><lib attr='3.5'/></shared>"
+        "</config>");
+    const jet::ConfigSource filtered(
+        source, jet::ConfigSource::Filter("app", "i1"), "filtered.xml", jet::ConfigSource::xml, jet::ConfigSource::CaseInsensitive);
+    EXPECT_EQ(
+        filtered.toString(jet::ConfigSource::OneLine),
+        "<config><app><attr>1</attr><instance><i1><attr>2</attr></i1></instance><sub><attr>a &amp; b</attr></sub></app>"
+        "<shared><lib><attr>3.5</attr></lib></shared></config>");
+    jet::Config config("app", "i1");
+    config << filtered << jet::lock;
+    std::ostringstream filteredOutput;
+    filteredOutput << config;
+    jet::Config expected("app", "i1");
+    expected <<
+        jet::ConfigSource("<config><App attr='1'><instance><i1 attr='2'/></instance><sub attr='a &amp; b'/></App>"
+            "<shared><lib attr='3.5'/></shared></config>",
+            "expected.xml", jet::ConfigSource::xml, jet::ConfigSource::CaseInsensitive) <<
+        jet::lock;
+    std::ostringstream expectedOutput;
+    expectedOutput << expected;
+    EXPECT_EQ(filteredOutput.str(), expectedOutput.str());
+    {//...names of filter are trimmed like names of config
+        const jet::ConfigSource spaced(
+            source, jet::ConfigSource::Filter(" app ", " i1 "), "spaced.xml", jet::ConfigSource::xml, jet::ConfigSource::CaseInsensitive);
+        EXPECT_EQ(spaced.toString(jet::ConfigSource::OneLine), filtered.toString(jet::ConfigSource::OneLine));
+        jet::Config spacedConfig("app", "i1");
+        spacedConfig << spaced << jet::lock;
+        std::ostringstream spacedOutput;
+        spacedOutput << spacedConfig;
+        EXPECT_EQ(spacedOutput.str(), expectedOutput.str());
+    }
+    EXPECT_EQ(
+        jet::ConfigSource("{\"other\": {\"a\": [1, 2]}, \"app\": {\"attr\": 1}}",
+            jet::ConfigSource::Filter("app"), "filtered.json", jet::ConfigSource::json).toString(jet::ConfigSource::OneLine),
+        "<config><app><attr>1</attr></app></config>");
+    CONFIG_ERROR(
+        jet::ConfigSource("<other><key attr=1/></other><app/>", jet::ConfigSource::Filter("app"), "broken.xml"),
+        "Couldn't parse config 'broken.xml'. Reason: <unspecified file>(1): expected ' or \"");
+    jet::Config another("app", "i2");
+    CONFIG_ERROR(
+        another << filtered,
+        "Config source 'filtered.xml' is filtered for config 'app:i1' and can't be merged into config 'app:i2'");
+}
+
+TEST(Config, MultipleConfigSourcesMerge)
+{
+    jet::ConfigSources sources;
+    sources.push_back(jet::ConfigSource("<app attr='1'><sub attr='1'><key/></sub><list/></app><shared><lib attr='1'/></shared>", "s1.xml"));
+    sources.push_back(jet::ConfigSource("<app><sub attr='2'/><list/></app><app:i1 attr='2'><sub>3</sub></app:i1>", "s2.xml"));
+    sources.push_back(jet::ConfigSource("<app><sub><key>4</key></sub><new attr='4'/></app><shared><lib other='4'/></shared>", "s3.xml"));
+    jet::Config sequential("app", "i1");
+    BOOST_FOREACH(const jet::ConfigSource& source, sources)
+        sequential << source;
+    jet::Config bulk("app", "i1");
+    bulk << sources;
+    std::ostringstream sequentialOutput;
+    sequentialOutput << sequential;
+    std::ostringstream bulkOutput;
+    bulkOutput << bulk;
+    EXPECT_EQ(sequentialOutput.str(), bulkOutput.str());
+    bulk << jet::lock;
+    EXPECT_EQ(bulk.get<std::string>("sub"), "3");
+    EXPECT_EQ(bulk.get<int>("lib.other"), 4);
+    //...the first error of sequential merge is reported, and config is left unchanged
+    sources.push_back(jet::ConfigSource("<app><list/><list/></app>", "s4.xml"));
+    sources.push_back(jet::ConfigSource("<app><sub/><sub/></app>", "s5.xml"));
+    jet::Config ambiguous("app");
+    ambiguous << sources.front();
+    std::ostringstream original;
+    original << ambiguous;
+    CONFIG_ERROR(
+        ambiguous << sources,
+        "Can't do ambiguous merge of node 'list' from config source 's4.xml' to config 'app'");
+    std::ostringstream unchanged;
+    unchanged << ambiguous;
+    EXPECT_EQ(original.str(), unchanged.str());
+    sources.insert(sources.begin() + 3, jet::ConfigSource("<app/>", jet::ConfigSource::Filter("other"), "filtered.xml"));
+    CONFIG_ERROR(
+        ambiguous << sources,
+        "Config source 'filtered.xml' is filtered for config 'other' and can't be merged into config 'app'");
+    std::ostringstream unfiltered;
+    unfiltered << ambiguous;
+    EXPECT_EQ(original.str(), unfiltered.str());
+    //...nodes which are overridden before the error are restored too
+    jet::ConfigSources overrides;
+    overrides.push_back(jet::ConfigSource("<app attr='2'><sub>value</sub><list><key/></list></app>", "o1.xml"));
+    overrides.push_back(jet::ConfigSource("<app><list/><list/></app>", "o2.xml"));
+    CONFIG_ERROR(
+        ambiguous << overrides,
+        "Can't do ambiguous merge of node 'list' from config source 'o2.xml' to config 'app'");
+    std::ostringstream restored;
+    restored << ambiguous;
+    EXPECT_EQ(original.str(), restored.str());
+    //...empty list of sources is merged into locked config as nothing
+    ambiguous << jet::lock;
+    ambiguous << jet::ConfigSources();
+    EXPECT_EQ(ambiguous.get<int>("attr"), 1);
+    CONFIG_ERROR(
+        ambiguous << overrides,
+        "Config 'app' is locked");
+}
+
+TEST(Config, FrozenAfterLock)
+{
+    jet::Config config("app", "i1");
+    const jet::ConfigNode copied(config);//...the handle is copied before lock, so it refers to the root
+    config <<
+        jet::ConfigSource("<app timeout='10'><db host='localhost' port='5432'/><key>1</key><key>2</key></app><app:i1 timeout='20'/>") <<
+        jet::lock;
+    EXPECT_EQ(copied.get<int>("timeout"), 20);
+    EXPECT_EQ(copied.get("db.host"), "localhost");
+    EXPECT_EQ(config.get("key"), "1");
+    EXPECT_EQ(config.getChildrenOf().size(), 4);
+    EXPECT_EQ(config.getNode("db").getChildrenOf()[1].get<int>(), 5432);
+    std::ostringstream configOutput;
+    configOutput << config;
+    std::ostringstream copiedOutput;
+    copiedOutput << copied;
+    EXPECT_EQ(configOutput.str(), copiedOutput.str());
+}
+
+TEST(Config, ConfigPath)
+{
+    jet::Config config("app", "i1");
+    config <<
+        jet::ConfigSource("<app timeout='10' name='a b'><db host='localhost' port='5432'/><key>1</key><key>2</key></app><app:i1 timeout='20'/>") <<
+        jet::lock;
+    const jet::ConfigPath timeout(" timeout ");
+    const jet::ConfigPath port("db.port");
+    const jet::ConfigPath missing("db.missing");
+    EXPECT_EQ(timeout.str(), "timeout");
+    EXPECT_EQ(config.get(timeout), "20");
+    EXPECT_EQ(config.get<int>(port), 5432);
+    EXPECT_EQ(config.get<std::string>(jet::ConfigPath("name")), "a b");
+    EXPECT_EQ(config.get(jet::ConfigPath("key")), "1");
+    EXPECT_EQ(config.getNode(jet::ConfigPath("db")).get<int>(jet::ConfigPath("port")), 5432);
+    EXPECT_EQ(config.getNode(jet::ConfigPath("db")).name(), "app:i1.db");
+    EXPECT_EQ(config.getNode(jet::ConfigPath("")).name(), "app:i1");
+    EXPECT_FALSE(config.getNodeOptional(missing));
+    EXPECT_FALSE(config.getOptional(missing));
+    EXPECT_FALSE(config.getOptional<int>(jet::ConfigPath("db")));
+    EXPECT_EQ(*config.getOptional<int>(port), 5432);
+    EXPECT_EQ(config.get(missing, 7), 7);
+    EXPECT_EQ(config.get(port, 7), 5432);
+    CONFIG_ERROR(config.get<int>(missing), "Can't find property 'db.missing' in config 'app:i1'");
+    CONFIG_ERROR(config.get(jet::ConfigPath("db")), "Node 'app:i1.db' is intermidiate node without value");
+    CONFIG_ERROR(config.get<int>(jet::ConfigPath("name")), "Can't convert value 'a b' of a property 'name' in config 'app:i1'");
+    CONFIG_ERROR(config.getNode(missing), "Config 'app:i1' doesn't have child 'db.missing'");
+    CONFIG_ERROR(jet::Config("app").get(timeout), "Initialization of config 'app' is not finished");
+}
+
+TEST(ConfigImage, Symbols)
+{
+    boost::property_tree::ptree tree;
+    for(unsigned i = 0; i != 100; ++i)
+    {
+        boost::property_tree::ptree& server(tree.add_child("server", boost::property_tree::ptree()));
+        server.put("host", "localhost");
+        server.put("port", 8000 + i % 2);
+    }
+    tree.push_back(std::make_pair(std::string(), boost::property_tree::ptree("empty")));
+    tree.add("a", "first");
+    const jet::ConfigImage image(tree, "app", std::string());
+    EXPECT_LT(image.size(), (100 * 3 + 3) * (sizeof(jet::ConfigImage::Node) + sizeof(jet::ConfigImage::Index)) + 1000);//...strings are stored once
+    const jet::ConfigImage::Index host = image.findSymbol("host", 4);
+    ASSERT_NE(host, jet::ConfigImage::noSymbol);
+    EXPECT_EQ(image.findSymbol("missing", 7), jet::ConfigImage::noSymbol);
+    EXPECT_NE(image.findSymbol("", 0), image.findSymbol("a", 1));
+    const jet::ConfigImage::Node* server = image.find(image.root(), image.findSymbol("server", 6));
+    ASSERT_TRUE(server);
+    EXPECT_EQ(server, image.childrenBegin(image.root()));//...the first one, like ptree::find
+    EXPECT_EQ(image.symbol(*image.find(*server, host)), host);
+    EXPECT_EQ(image.data(*image.findPath(image.root(), "server.port")), "8000");
+    EXPECT_EQ(image.data(*image.find(image.root(), "", 0)), "empty");
+    EXPECT_EQ(image.data(*image.find(image.root(), "a", 1)), "first");
+}
+
+TEST(Config, PathIndex)
+{
+    jet::Config config("app");
+    config <<
+        jet::ConfigSource("<app><db host='h1' port='1'/><db host='h2'/><pool><size>4</size></pool></app>") <<
+        jet::ConfigSource("{ \"app\": { \"a.b\": \"dotted\", \"\": { \"x\": \"empty\" } } }", "s.json", jet::ConfigSource::json) <<
+        jet::lock;
+    EXPECT_EQ(config.get("db.host"), "h1");
+    EXPECT_EQ(config.get(jet::ConfigPath("pool.size")), "4");
+    const jet::ConfigNode pool(config.getNode("pool"));
+    EXPECT_EQ(pool.get("size"), "4");
+    EXPECT_EQ(pool.get(jet::ConfigPath("size")), "4");
+    const jet::ConfigNodes dbs(config.getChildrenOf(""));
+    ASSERT_GE(dbs.size(), 2u);
+    EXPECT_EQ(dbs[1].path(), "db");//...the same path as the first one, but it isn't in the index
+    EXPECT_EQ(dbs[1].get("host"), "h2");
+    EXPECT_FALSE(dbs[1].getOptional("port"));
+    EXPECT_EQ(config.get(".x"), "empty");//...names which aren't in the index are found too
+    EXPECT_FALSE(config.getOptional("a.b"));
+    std::vector<std::pair<std::string, std::string> > properties(config.getProperties());
+    std::sort(properties.begin(), properties.end());
+    ASSERT_EQ(properties.size(), 3u);
+    EXPECT_EQ(properties[0], std::make_pair(std::string("db.host"), std::string("h1")));
+    EXPECT_EQ(properties[1], std::make_pair(std::string("db.port"), std::string("1")));
+    EXPECT_EQ(properties[2], std::make_pair(std::string("pool.size"), std::string("4")));
+    CONFIG_ERROR(jet::Config("app").getProperties(), "Initialization of config 'app' is not finished");
+}
+
+namespace
+{
+
+void readPort(const jet::Config& config, const jet::ConfigPath& port, unsigned& sum)
+{
+    for(unsigned i = 0; i != 1000; ++i)
+        sum += config.get<unsigned>(port) + static_cast<unsigned>(config.get<double>(port) * 2);
+}
+
+}//anonymous namespace
+
+TEST(Config, ValueCache)
+{
+    jet::Config config("app");
+    config << jet::ConfigSource("<app port='80' ratio='0.5' name='a b'/>") << jet::lock;
+    EXPECT_EQ(config.get<int>("port"), 80);
+    EXPECT_EQ(config.get<int>("port"), 80);
+    EXPECT_EQ(config.get<double>("port"), 80.0);
+    EXPECT_EQ(config.get<std::string>("port"), "80");
+    EXPECT_EQ(config.get<int>(jet::ConfigPath("port")), 80);
+    EXPECT_EQ(*config.getOptional<double>("ratio"), 0.5);
+    EXPECT_EQ(config.get<double>(" ratio ", 1.0), 0.5);
+    CONFIG_ERROR(config.get<int>("name"), "Can't convert value 'a b' of a property 'name' in config 'app'");
+    CONFIG_ERROR(config.get<int>("name"), "Can't convert value 'a b' of a property 'name' in config 'app'");
+    EXPECT_EQ(config.get<std::string>("name"), "a b");
+    const jet::ConfigPath port("port");
+    std::vector<unsigned> sums(4, 0);
+    boost::thread_group readers;
+    for(size_t reader = 0; reader != sums.size(); ++reader)
+        readers.create_thread(boost::bind(readPort, boost::cref(config), boost::cref(port), boost::ref(sums[reader])));
+    readers.join_all();
+    BOOST_FOREACH(unsigned sum, sums)
+        EXPECT_EQ(sum, 240000u);
+}
+
+namespace
+{
+
+struct Endpoint
+{
+    std::string host;
+    unsigned short port;
+};
+
+}//anonymous namespace
+
+namespace jet
+{
+
+template<>
+struct ConfigConverter<Endpoint>
+{
+    static bool convert(const char* value, size_t size, Endpoint& result)
+    {
+        const char* const colon = std::find(value, value + size, ':');
+        if(value + size == colon)
+            return false;
+        result.host.assign(value, colon);
+        return ConfigConverter<unsigned short>::convert(colon + 1, value + size - colon - 1, result.port);
+    }
+};
+
+}//namespace jet
+
+TEST(Config, ValueConverters)
+{
+    jet::Config config("app");
+    config <<
+        jet::ConfigSource(
+            "<app big='4294967296' negative='-12' plus='+7' spaced=' 5' ratio='1.25e2' flag='true' off='0' "
+            "timeout='250ms' period='2 min' bare='30' half='1500ms' limit='64MiB' disk='10GB' plain='512' "
+            "huge='20000000TiB' endpoint='localhost:8080' char='x'/>") <<
+        jet::lock;
+    EXPECT_EQ(config.get<long long>("big"), 4294967296LL);
+    CONFIG_ERROR(config.get<int>("big"), "Can't convert value '4294967296' of a property 'big' in config 'app'");
+    EXPECT_EQ(config.get<int>("negative"), -12);
+    CONFIG_ERROR(config.get<unsigned>("negative"), "Can't convert value '-12' of a property 'negative' in config 'app'");
+    EXPECT_EQ(config.get<short>("plus"), 7);
+    CONFIG_ERROR(config.get<int>("spaced"), "Can't convert value ' 5' of a property 'spaced' in config 'app'");
+    EXPECT_EQ(config.get<double>("ratio"), 125.0);
+    EXPECT_EQ(config.get<float>("ratio"), 125.0f);
+    EXPECT_TRUE(config.get<bool>("flag"));
+    EXPECT_FALSE(config.get<bool>("off"));
+    CONFIG_ERROR(config.get<bool>("plus"), "Can't convert value '+7' of a property 'plus' in config 'app'");
+    EXPECT_EQ(config.get<boost::chrono::milliseconds>("timeout"), boost::chrono::milliseconds(250));
+    EXPECT_EQ(config.get<boost::chrono::microseconds>("timeout"), boost::chrono::microseconds(250000));
+    EXPECT_EQ(config.get<boost::chrono::seconds>("period"), boost::chrono::seconds(120));
+    EXPECT_EQ(config.get<boost::chrono::seconds>("bare"), boost::chrono::seconds(30));
+    CONFIG_ERROR(config.get<boost::chrono::seconds>("half"), "Can't convert value '1500ms' of a property 'half' in config 'app'");
+    CONFIG_ERROR(config.get<boost::chrono::seconds>("limit"), "Can't convert value '64MiB' of a property 'limit' in config 'app'");
+    EXPECT_EQ(config.get<jet::ByteSize>("limit"), jet::ByteSize(64 << 20));
+    EXPECT_EQ(config.get<jet::ByteSize>("disk").bytes(), 10000000000ULL);
+    EXPECT_EQ(config.get<jet::ByteSize>("plain"), jet::ByteSize(512));
+    CONFIG_ERROR(config.get<jet::ByteSize>("huge"), "Can't convert value '20000000TiB' of a property 'huge' in config 'app'");
+    CONFIG_ERROR(config.get<jet::ByteSize>("timeout"), "Can't convert value '250ms' of a property 'timeout' in config 'app'");
+    EXPECT_EQ(config.get<Endpoint>("endpoint").host, "localhost");
+    EXPECT_EQ(config.get<Endpoint>("endpoint").port, 8080);
+    CONFIG_ERROR(config.get<Endpoint>("char"), "Can't convert value 'x' of a property 'char' in config 'app'");
+    EXPECT_EQ(config.get<char>("char"), 'x');
+    //...floating point numbers are rounded correctly, so printed ones are read back exactly
+    double parsed = 0;
+    ASSERT_TRUE(jet::ConfigConverter<double>::convert("216016.08649505815", 18, parsed));
+    EXPECT_EQ(parsed, std::strtod("216016.08649505815", 0));
+    EXPECT_FALSE(jet::ConfigConverter<double>::convert("0x10", 4, parsed));
+    EXPECT_FALSE(jet::ConfigConverter<double>::convert("1e400", 5, parsed));
+    EXPECT_FALSE(jet::ConfigConverter<double>::convert("1.5 ", 4, parsed));
+    boost::uint64_t bits = 12345;
+    for(unsigned i = 0; i != 10000; ++i)
+    {
+        bits = bits * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+        double expected = 0;
+        std::memcpy(&expected, &bits, sizeof(expected));
+        char value[64];
+        if(boost::math::isfinite(expected))
+        {
+            const int size = std::sprintf(value, "%.17g", expected);
+            ASSERT_TRUE(jet::ConfigConverter<double>::convert(value, size, parsed)) << value;
+            EXPECT_EQ(parsed, expected) << value;
+        }
+        float expectedFloat = 0;
+        const boost::uint32_t floatBits = static_cast<boost::uint32_t>(bits >> 32);
+        std::memcpy(&expectedFloat, &floatBits, sizeof(expectedFloat));
+        if(boost::math::isfinite(expectedFloat))
+        {
+            float parsedFloat = 0;
+            const int size = std::sprintf(value, "%.9g", expectedFloat);
+            ASSERT_TRUE(jet::ConfigConverter<float>::convert(value, size, parsedFloat)) << value;
+            EXPECT_EQ(parsedFloat, expectedFloat) << value;
+        }
+    }
+}
+
+namespace
+{
+
+struct ServerSettings
+{
+    std::string host;
+    unsigned short port;
+    boost::chrono::milliseconds timeout;
+    jet::ByteSize buffer;
+    bool verbose;
+};
+
+const jet::ConfigBinding<ServerSettings>& serverBinding()
+{
+    static const jet::ConfigBinding<ServerSettings> binding = jet::ConfigBinding<ServerSettings>()
+        .field(&ServerSettings::host, "server.host")
+        .field(&ServerSettings::port, "server.port")
+        .field(&ServerSettings::timeout, "server.timeout", boost::chrono::milliseconds(100))
+        .field(&ServerSettings::buffer, "server.buffer", jet::ByteSize(4096))
+        .field(&ServerSettings::verbose, "verbose");
+    return binding;
+}
+
+}//anonymous namespace
+
+TEST(Config, Binding)
+{
+    jet::Config config("app", "i1");
+    config <<
+        jet::ConfigSource("<app verbose='true'><server host='localhost' port='80' buffer='64KiB'/></app><app:i1><server timeout='2s'/></app:i1>") <<
+        jet::lock;
+    const ServerSettings settings(serverBinding().bind(config));
+    EXPECT_EQ(settings.host, "localhost");
+    EXPECT_EQ(settings.port, 80);
+    EXPECT_EQ(settings.timeout, boost::chrono::milliseconds(2000));
+    EXPECT_EQ(settings.buffer, jet::ByteSize(64 << 10));
+    EXPECT_TRUE(settings.verbose);
+    const jet::ConfigBinding<ServerSettings> serverNodeBinding = jet::ConfigBinding<ServerSettings>()
+        .field(&ServerSettings::host, "host")
+        .field(&ServerSettings::buffer, "size", jet::ByteSize(1));
+    const ServerSettings nodeSettings(serverNodeBinding.bind(config.getNode("server")));
+    EXPECT_EQ(nodeSettings.host, "localhost");
+    EXPECT_EQ(nodeSettings.buffer, jet::ByteSize(1));
+
+    jet::Config invalid("app");
+    invalid << jet::ConfigSource("<app verbose='yes'><server port='http'/></app>") << jet::lock;
+    ServerSettings unchanged(settings);
+    CONFIG_ERROR(
+        serverBinding().bind(invalid, unchanged),
+        "Can't bind config 'app':\n"
+        "    Can't find property 'server.host' in config 'app'\n"
+        "    Can't convert value 'http' of a property 'server.port' in config 'app'\n"
+        "    Can't convert value 'yes' of a property 'verbose' in config 'app'");
+    EXPECT_EQ(unchanged.host, "localhost");//...nothing is assigned
+    EXPECT_EQ(unchanged.port, 80);
+    jet::Config unlocked("app");
+    CONFIG_ERROR(
+        serverBinding().bind(unlocked, unchanged),
+        "Initialization of config 'app' is not finished");
+}
+
+TEST(Config, NodeView)
+{
+    jet::Config config("app", "i1");
+    config <<
+        jet::ConfigSource("<app><db host='h1' port='1'><pool size='4'/></db><db host='h2'/></app><app:i1 timeout='2'/>") <<
+        jet::lock;
+    const jet::ConfigNodeView root(config.view());
+    EXPECT_EQ(root.name(), "app:i1");
+    EXPECT_EQ(root.get<int>("timeout"), 2);
+    const jet::ConfigNodeView db(root.getNode("db"));
+    EXPECT_EQ(db.path(), "db");
+    EXPECT_EQ(db.name(), "app:i1.db");
+    EXPECT_EQ(db.get("host"), "h1");
+    EXPECT_EQ(db.get<int>(jet::ConfigPath("pool.size")), 4);
+    EXPECT_EQ(db.getNode(jet::ConfigPath("pool")).name(), "app:i1.db.pool");
+    EXPECT_EQ(db.getNode("pool").nodeName(), "pool");
+    EXPECT_EQ(db.get("missing", "default"), "default");
+    EXPECT_FALSE(db.getNodeOptional("missing"));
+    EXPECT_FALSE(db.getOptional<int>("pool"));
+    std::vector<jet::ConfigNodeView> dbs;
+    BOOST_FOREACH(const jet::ConfigNodeView& child, root.getChildrenOf())
+    {
+        if(child.nodeName() == "db")
+            dbs.push_back(child);
+    }
+    ASSERT_EQ(dbs.size(), 2u);
+    EXPECT_EQ(dbs[1].path(), "db");
+    EXPECT_EQ(dbs[1].get("host"), "h2");//...node with the same path as the first one
+    EXPECT_EQ(dbs[0].getNode("pool").get<int>("size"), 4);
+    const jet::ConfigNode pool(dbs[0].getNode("pool").node());
+    EXPECT_EQ(pool.name(), "app:i1.db.pool");
+    //...view of a temporary handle stays valid while its config exists
+    const jet::ConfigNodeView temporary(config.getNode("db").view());
+    EXPECT_EQ(temporary.name(), "app:i1.db");
+    CONFIG_ERROR(temporary.get("missing"), "Can't find property 'missing' in config 'app:i1.db'");
+    EXPECT_EQ(pool.get<int>("size"), 4);
+    CONFIG_ERROR(db.get("pool"), "Node 'app:i1.db.pool' is intermidiate node without value");
+    CONFIG_ERROR(db.get<int>("host"), "Can't convert value 'h1' of a property 'host' in config 'app:i1.db'");
+    CONFIG_ERROR(db.getNode("missing"), "Config 'app:i1.db' doesn't have child 'missing'");
+    CONFIG_ERROR(jet::Config("app").view(), "Initialization of config 'app' is not finished");
+}
+
+namespace
+{
+
+bool isR2(const jet::ConfigNodeView& node)
+{
+    return "r2" == node.rawName();
+}
+
+}//anonymous namespace
+
+TEST(Config, ChildrenRange)
+{
+    jet::Config config("app");
+    config <<
+        jet::ConfigSource("<app><routes><r1 port='1'/><r2 port='2'/><r1 port='3'/></routes><empty/></app>") <<
+        jet::lock;
+    const jet::ConfigChildren routes(config.view().children(jet::ConfigPath("routes")));
+    ASSERT_EQ(routes.size(), 3u);
+    std::string names;
+    int ports = 0;
+    BOOST_FOREACH(const jet::ConfigNodeView& route, routes)
+    {
+        names += route.rawName().to_string();
+        ports = ports * 10 + route.get<int>("port");
+    }
+    EXPECT_EQ(names, "r1r2r1");
+    EXPECT_EQ(ports, 123);
+    EXPECT_EQ(routes.end() - routes.begin(), 3);
+    EXPECT_EQ(routes.at(2).get("port"), "3");//...the same path as the first one
+    EXPECT_EQ(routes.at(1).path(), "routes.r2");
+    EXPECT_EQ((*routes.begin()).getNode("port").rawValue(), "1");
+    EXPECT_TRUE(config.view().children(jet::ConfigPath("empty")).empty());
+    EXPECT_EQ(config.view().children().size(), 2u);
+    EXPECT_THROW(config.view().children(jet::ConfigPath("missing")), boost::property_tree::ptree_bad_path);
+    //...iterator refers to the node, so it's used after its range is gone
+    const jet::ConfigNodeView routesView(config.view().getNode("routes"));
+    const jet::ConfigChildren::iterator r2 = std::find_if(
+        routesView.children().begin(),
+        routesView.children().end(),
+        isR2);
+    EXPECT_EQ(r2->get<int>("port"), 2);
+    EXPECT_EQ(r2 - routesView.children().begin(), 1);
+    EXPECT_TRUE(routes.begin() != config.view().children().begin());//...ranges of different nodes
+    EXPECT_TRUE(routes.begin() == routesView.children().begin());
+}
+
+namespace
+{
+
+//...reloads are done on background thread, test waits for them
+bool waitForReloads(
+    const jet::ConfigReloader& reloader,
+    unsigned long reloads,
+    unsigned long failures,
+    unsigned long callbackFailures = 0)
+{
+    for(unsigned i = 0; i != 500; ++i)
+    {
+        const jet::ConfigReloader::Statistics statistics(reloader.statistics());
+        if(statistics.reloads >= reloads && statistics.failures >= failures && statistics.callbackFailures >= callbackFailures)
+            return true;
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    return false;
+}
+
+void timeoutChanged(jet::ConfigReloader& reloader, std::vector<int>& timeouts, const jet::ConfigChange& change)
+{
+    const int timeout = change.current.get<int>("timeout");
+    timeouts.push_back(timeout);
+    if(60 == timeout)
+        throw jet::ConfigError("Timeout 60 isn't supported");
+    if(70 == timeout)
+        throw timeout;
+    if(80 == timeout)
+        reloader.reload();//...config is the same, so this callback isn't called again
+}
+
+}//anonymous namespace
+
+TEST(Config, Reloader)
+{
+    namespace FS = boost::filesystem;
+    const FS::path directory(temporaryPath("JetConfigReloaderTest-%%%%-%%%%-%%%%.d"));
+    FS::create_directory(directory);
+    const std::string shared((directory / "shared.xml").string());
+    const std::string app((directory / "app.xml").string());
+    std::ofstream(shared.c_str()) << "<config><shared><db port='5432'/></shared></config>";
+    std::ofstream(app.c_str()) << "<config><app timeout='10'/></config>";
+    std::vector<std::string> filenames;
+    filenames.push_back(shared);
+    filenames.push_back(app);
+    jet::ConfigReloader reloader("app", "", filenames, jet::ConfigSource::xml, 20);
+    const boost::shared_ptr<const jet::Config> first(reloader.get());
+    EXPECT_EQ(first->get<int>("timeout"), 10);
+    EXPECT_EQ(first->get<int>("db.port"), 5432);
+
+    std::ofstream(app.c_str()) << "<config><app timeout='20'/></config>";
+    ASSERT_TRUE(waitForReloads(reloader, 1, 0));
+    EXPECT_EQ(reloader.get()->get<int>("timeout"), 20);
+    EXPECT_EQ(first->get<int>("timeout"), 10);//...config which is held stays the same
+    {//...file is replaced by rename, like editors do
+        const std::string temp((directory / "app.xml.tmp").string());
+        std::ofstream(temp.c_str()) << "<config><app timeout='30'/></config>";
+        FS::rename(temp, app);
+    }
+    ASSERT_TRUE(waitForReloads(reloader, 2, 0));
+    EXPECT_EQ(reloader.get()->get<int>("timeout"), 30);
+    std::ofstream((directory / "other.xml").string().c_str()) << "<config/>";
+
+    std::ofstream(app.c_str()) << "<config><app timeout='40'>";
+    ASSERT_TRUE(waitForReloads(reloader, 2, 1));
+    EXPECT_EQ(reloader.get()->get<int>("timeout"), 30);//...current config is kept
+    EXPECT_FALSE(reloader.statistics().lastError.empty());
+    EXPECT_ANY_THROW(reloader.reload());
+    EXPECT_EQ(reloader.statistics().reloads, 2u);//...other file isn't watched
+
+    std::ofstream(app.c_str()) << "<config><app timeout='50'/></config>";
+    reloader.reload();
+    EXPECT_EQ(reloader.get()->get<int>("timeout"), 50);
+    EXPECT_GT(reloader.statistics().lastRebuildSeconds, 0);
+    EXPECT_EQ(reloader.statistics().callbackFailures, 0u);
+
+    //...exceptions of callbacks are in statistics, and callbacks can reload config
+    std::vector<int> timeouts;
+    reloader.subscriptions().subscribe(
+        "timeout",
+        boost::bind(&timeoutChanged, boost::ref(reloader), boost::ref(timeouts), _1));
+    std::ofstream(app.c_str()) << "<config><app timeout='60'/></config>";
+    ASSERT_TRUE(waitForReloads(reloader, 0, 0, 1));
+    EXPECT_EQ(reloader.statistics().lastCallbackError, "Timeout 60 isn't supported");
+    std::ofstream(app.c_str()) << "<config><app timeout='70'/></config>";
+    ASSERT_TRUE(waitForReloads(reloader, 0, 0, 2));
+    EXPECT_EQ(reloader.statistics().lastCallbackError, "unknown exception");
+    const unsigned long reloads = reloader.statistics().reloads;
+    std::ofstream(app.c_str()) << "<config><app timeout='80'/></config>";
+    ASSERT_TRUE(waitForReloads(reloader, reloads + 2, 0));
+    EXPECT_EQ(reloader.get()->get<int>("timeout"), 80);
+    EXPECT_EQ(reloader.statistics().callbackFailures, 2u);
+    ASSERT_FALSE(timeouts.empty());
+    EXPECT_EQ(timeouts.front(), 60);
+    EXPECT_EQ(timeouts.back(), 80);
+    FS::remove_all(directory);
+}
+
+namespace
+{
+
+boost::shared_ptr<const jet::Config> makeVersion(int version)
+{
+    const boost::shared_ptr<jet::Config> config(new jet::Config("app", ""));
+    *config << jet::ConfigSource("<config><app version='" + boost::lexical_cast<std::string>(version) + "'/></config>")
+        << jet::lock;
+    return config;
+}
+
+//...every thread checks that versions it reads never go back
+void readVersions(jet::ConfigSnapshots& snapshots, const boost::atomic<bool>& isStopped, int& errors)
+{
+    jet::ConfigSnapshots::Reader reader(snapshots);
+    const jet::ConfigPath path("version");
+    int last = 0;
+    while(!isStopped.load())
+    {
+        const jet::ConfigSnapshots::Snapshot config(reader);
+        const int version = config->get<int>(path);
+        errors += version < last;
+        last = version;
+    }
+}
+
+}//anonymous namespace
+
+TEST(Config, SnapshotPublication)
+{
+    jet::ConfigSnapshots snapshots(makeVersion(1));
+    boost::weak_ptr<const jet::Config> first;
+    {
+        jet::ConfigSnapshots::Reader reader(snapshots);
+        {
+            const jet::ConfigSnapshots::Snapshot config(reader);
+            EXPECT_EQ(config->get<int>("version"), 1);
+            first = snapshots.get();
+            snapshots.publish(makeVersion(2));
+            EXPECT_EQ(snapshots.retired(), 1u);
+            EXPECT_FALSE(first.expired());
+            EXPECT_EQ(config->get<int>("version"), 1);//...config of snapshot stays the same
+            const jet::ConfigSnapshots::Snapshot nested(reader);
+            EXPECT_EQ(nested->get<int>("version"), 2);
+        }
+        const boost::weak_ptr<const jet::Config> second(snapshots.get());
+        snapshots.publish(makeVersion(3));
+        EXPECT_EQ(snapshots.retired(), 0u);
+        EXPECT_TRUE(first.expired());
+        EXPECT_TRUE(second.expired());
+        const jet::ConfigSnapshots::Snapshot config(reader);
+        EXPECT_EQ(config->get<int>("version"), 3);
+        EXPECT_EQ(snapshots.get()->get<int>("version"), 3);
+    }
+
+    boost::atomic<bool> isStopped(false);
+    int errors[4] = { 0 };
+    boost::thread_group readers;
+    for(size_t i = 0; i != 4; ++i)
+        readers.create_thread(boost::bind(&readVersions, boost::ref(snapshots), boost::cref(isStopped), boost::ref(errors[i])));
+    std::vector<boost::weak_ptr<const jet::Config> > published;
+    for(int version = 4; version != 200; ++version)
+    {
+        published.push_back(snapshots.get());
+        snapshots.publish(makeVersion(version));
+    }
+    isStopped.store(true);
+    readers.join_all();
+    EXPECT_EQ(snapshots.retired(), 0u);
+    BOOST_FOREACH(const boost::weak_ptr<const jet::Config>& config, published)
+        EXPECT_TRUE(config.expired());
+    EXPECT_EQ(errors[0] + errors[1] + errors[2] + errors[3], 0);
+}
+
+namespace
+{
+
+boost::shared_ptr<const jet::Config> makeLockedConfig(const std::string& xml)
+{
+    const boost::shared_ptr<jet::Config> config(new jet::Config("app", ""));
+    *config << jet::ConfigSource(xml) << jet::lock;
+    return config;
+}
+
+void recordChange(std::vector<std::string>& changes, const std::string& prefix, const jet::ConfigChange& change)
+{
+    changes.push_back(prefix + change.path);
+}
+
+void throwChange(const std::string& message, const jet::ConfigChange&)
+{
+    throw std::runtime_error(message);
+}
+
+}//anonymous namespace
+
+TEST(Config, Subscriptions)
+{
+    const boost::shared_ptr<const jet::Config> first(makeLockedConfig(
+        "<config><app><database host='db1' port='5432'/>"
+        "<routes><api url='/api'/><web url='/'/><static url='/s'/></routes><log level='info'/></app></config>"));
+    const boost::shared_ptr<const jet::Config> same(makeLockedConfig(
+        "<config><app><database host='db1' port='5432'/>"
+        "<routes><api url='/api'/><web url='/'/><static url='/s'/></routes><log level='info'/></app></config>"));
+    const boost::shared_ptr<const jet::Config> second(makeLockedConfig(
+        "<config><app><database host='db2' port='5432'/>"
+        "<routes><api url='/api/v2'/><web url='/'/><admin url='/a'/></routes><log level='info'/></app></config>"));
+    EXPECT_EQ(first->view().contentHash(), same->view().contentHash());
+    EXPECT_NE(first->view().contentHash(), second->view().contentHash());
+    EXPECT_EQ(first->getNode("log").view().contentHash(), second->getNode("log").view().contentHash());
+    EXPECT_NE(first->getNode("database").view().contentHash(), first->getNode("log").view().contentHash());
+
+    jet::ConfigSubscriptions subscriptions;
+    std::vector<std::string> changes;
+    subscriptions.subscribe("database", boost::bind(&recordChange, boost::ref(changes), "1:", _1));
+    subscriptions.subscribe("routes.*", boost::bind(&recordChange, boost::ref(changes), "2:", _1));
+    subscriptions.subscribe(" log ", boost::bind(&recordChange, boost::ref(changes), "3:", _1));
+    subscriptions.subscribe("missing.*", boost::bind(&recordChange, boost::ref(changes), "4:", _1));
+    subscriptions.subscribe("*.port", boost::bind(&recordChange, boost::ref(changes), "5:", _1));
+    const jet::ConfigSubscriptions::Id all =
+        subscriptions.subscribe("", boost::bind(&recordChange, boost::ref(changes), "6:", _1));
+    subscriptions.notify(*first, *same);
+    EXPECT_TRUE(changes.empty());
+
+    subscriptions.notify(*first, *second);
+    std::sort(changes.begin(), changes.end());
+    const char* const expected[] = { "1:database", "2:routes.admin", "2:routes.api", "2:routes.static", "6:" };
+    EXPECT_EQ(changes, std::vector<std::string>(expected, expected + sizeof(expected) / sizeof(expected[0])));
+
+    changes.clear();
+    subscriptions.unsubscribe(all);
+    subscriptions.notify(*second, *first);
+    EXPECT_EQ(changes.size(), 4u);
+    EXPECT_EQ(std::count(changes.begin(), changes.end(), "6:"), 0);
+
+    //...repeated nodes are compared by occurrence
+    const boost::shared_ptr<const jet::Config> repeated(makeLockedConfig(
+        "<config><app><routes><route url='/a'/><route url='/b'/><other/></routes></app></config>"));
+    const boost::shared_ptr<const jet::Config> secondEdited(makeLockedConfig(
+        "<config><app><routes><route url='/a'/><route url='/c'/><other/></routes></app></config>"));
+    const boost::shared_ptr<const jet::Config> thirdAdded(makeLockedConfig(
+        "<config><app><routes><route url='/a'/><route url='/c'/><route url='/d'/><other/></routes></app></config>"));
+    const boost::shared_ptr<const jet::Config> moved(makeLockedConfig(
+        "<config><app><routes><other/><route url='/a'/><route url='/c'/><route url='/d'/></routes></app></config>"));
+    jet::ConfigSubscriptions repeatedSubscriptions;
+    changes.clear();
+    repeatedSubscriptions.subscribe("routes.*", boost::bind(&recordChange, boost::ref(changes), "1:", _1));
+    repeatedSubscriptions.subscribe("routes.route.url", boost::bind(&recordChange, boost::ref(changes), "2:", _1));
+    repeatedSubscriptions.subscribe("routes.other", boost::bind(&recordChange, boost::ref(changes), "3:", _1));
+    repeatedSubscriptions.notify(*repeated, *secondEdited);
+    const char* const edited[] = { "1:routes.route", "2:routes.route.url" };
+    EXPECT_EQ(changes, std::vector<std::string>(edited, edited + 2));
+    changes.clear();
+    repeatedSubscriptions.notify(*secondEdited, *thirdAdded);
+    EXPECT_EQ(changes, std::vector<std::string>(edited, edited + 2));
+    changes.clear();
+    repeatedSubscriptions.notify(*thirdAdded, *secondEdited);
+    EXPECT_EQ(changes, std::vector<std::string>(edited, edited + 2));
+    changes.clear();
+    repeatedSubscriptions.notify(*thirdAdded, *moved);//...the same nodes in other order
+    EXPECT_TRUE(changes.empty());
+
+    //...exception of a callback doesn't cancel the other subscriptions, the first one is passed on
+    jet::ConfigSubscriptions failingSubscriptions;
+    changes.clear();
+    failingSubscriptions.subscribe("database", boost::bind(&throwChange, "first", _1));
+    failingSubscriptions.subscribe("database", boost::bind(&recordChange, boost::ref(changes), "2:", _1));
+    failingSubscriptions.subscribe("database", boost::bind(&throwChange, "third", _1));
+    failingSubscriptions.subscribe("database", boost::bind(&recordChange, boost::ref(changes), "4:", _1));
+    try
+    {
+        failingSubscriptions.notify(*first, *second);
+        ADD_FAILURE() << "exception of the callback isn't passed on";
+    }
+    catch(const std::runtime_error& ex)
+    {
+        EXPECT_EQ(std::string(ex.what()), "first");
+    }
+    const char* const notified[] = { "2:database", "4:database" };
+    EXPECT_EQ(changes, std::vector<std::string>(notified, notified + 2));
+}
+
 //TODO: test xml comments
 //TODO: (SourceConfig) prohibit '.' separator everywhere except application name
 //TODO: add command line config source